@@ -14,8 +14,17 @@ $BUILD_DIR = "build"
 
 $SRC_FILES = @(
     "$SRC_DIR/checksum.cpp",
+    "$SRC_DIR/histogram.cpp",
     "$SRC_DIR/stats.cpp",
     "$SRC_DIR/error_injector.cpp",
+    "$SRC_DIR/dashboard.cpp",
+    "$SRC_DIR/stats_export.cpp",
+    "$SRC_DIR/input_stream.cpp",
+    "$SRC_DIR/mapped_file.cpp",
+    "$SRC_DIR/message_arena.cpp",
+    "$SRC_DIR/raw_output.cpp",
+    "$SRC_DIR/group_writer.cpp",
+    "$SRC_DIR/link_daemon.cpp",
     "$SRC_DIR/b15board.cpp",
     "$SRC_DIR/main.cpp"
 )
@@ -4,6 +4,8 @@
 #include <string>
 #include <cstdint>
 #include <b15f/b15f.h>
+#include "group_writer.h"
+#include "link_daemon.h"
 
 class B15Board
 {
@@ -13,19 +15,42 @@ public:
     B15Board(std::string board_name, bool verb = false);
 
     void set_verbose(bool v);
+    // Ausgabe der Full-Duplex-Empfänger (received_X.txt)
+    void set_writer_settings(const WriterSettings &s);
+    // Ab welcher Größe empfangene Nachrichten in eine Datei ausgelagert werden
+    void set_spill_settings(const SpillSettings &s);
+    // Empfangsfenster und Nachfrage-Intervall der Credit-Flusskontrolle
+    void set_flow_settings(const FlowSettings &s);
 
     // Operation Modes
     void run_sender_mode();
+    void run_send_file_mode(const std::string &path); // Datei per mmap, eine Nachricht
     void run_receiver_mode();
+    void run_raw_receiver_mode(); // Nur Nutzdaten auf stdout, endet wenn stdout zu ist
     void run_fullduplex_mode();
+    // Link für lokale Clients über daemon (siehe link_daemon.h), läuft bis daemon stoppt
+    void run_daemon_mode(LinkDaemon &daemon);
 
     // High-Level Protocol
     bool send_byte_with_checksum(uint8_t byte);
     uint8_t receive_byte_with_checksum();
 
+    // Gegenseite meldet vollen Puffer; vor dem nächsten Nutzdaten-Byte warten
+    bool credit_blocked() const { return tx_credit == 0; }
+    // Fragt mit PROBE_BYTE nach, bis wieder Credit da ist; false bei Leitungsfehler
+    bool wait_for_credit();
+
 private:
     B15F &drv;
     bool verbose;
+    WriterSettings writer_settings;
+    SpillSettings spill_settings;
+    FlowSettings flow_settings;
+
+    BacklogSource *rx_consumer; // Bestimmt den Credit in unseren ACKs, nullptr = ACK_BYTE
+    long tx_credit;             // Platz bei der Gegenseite laut letztem ACK, -1 = unbegrenzt
+    bool tx_channel_id;         // Nächstes gesendetes Byte ist eine Kanalnummer (Statistik)
+    bool rx_channel_id;         // dito, empfangen
 
     // TX (Senden) Zustände
     uint8_t tx_clock_state;
@@ -43,16 +68,29 @@ private:
     // Low-Level B15F Access
     void write_output(uint8_t data);
     uint8_t read_input();
+    void poll_sleep();
+    void record_polls(int polls, bool completed);
+    uint8_t ack_byte();
 
     // Protocol Layer
     bool send_2bits(uint8_t data);
     uint8_t receive_2bits();
     bool send_byte_raw(uint8_t byte);
-    uint8_t receive_byte_raw();
+    bool receive_byte_raw(uint8_t &byte, uint64_t *first_symbol_ns = nullptr); // false = Timeout
+
+    // Nachrichten-Layer
+    bool send_payload_byte(uint8_t byte); // Mit Byte-Stuffing
+    bool send_block(const uint8_t *data, size_t len);
+    bool send_input_stream(const std::string &tag);
+    bool finish_message(const std::string &tag, size_t message_bytes, uint64_t message_start_ns);
+    bool send_abort(const std::string &tag); // ABORT_BYTE nach einem Fehler mitten in einer Nachricht
 
     // Full-Duplex Threads
     void sender_thread();
     void receiver_thread();
+
+    // Turn-taking (Full-Duplex und Daemon)
+    void run_ping_pong(LinkDaemon *daemon);
 };
 
 // Globaler Mutex für B15F-Zugriffe
@@ -0,0 +1,134 @@
+#ifndef LINK_DAEMON_H
+#define LINK_DAEMON_H
+
+#include "message_arena.h"
+#include "protocol.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Ausschnitt (höchstens FRAME_BYTES) einer Client-Nachricht für den Link
+struct OutgoingFrame
+{
+    uint64_t client;  // Wer die Bestätigung bekommt
+    uint64_t message; // Laufende Nummer der Nachricht
+    int channel;
+    std::vector<uint8_t> data;
+    bool first; // Anfang der Nachricht
+    bool last;  // Danach folgt EOT
+};
+
+// Lokaler Daemon, der einen Link für viele Prozesse bereitstellt. Das Board
+// wird einmal initialisiert und bleibt warm; Clients verbinden sich über
+// einen Unix-Domain-Socket. Protokoll (Kopfzeile als Text, Nutzdaten binär):
+//
+//   Client -> Daemon:  "SEND <n> [<kanal>]\n" + n Bytes   Nachricht einreihen
+//                      "SUBSCRIBE\n"            Empfangene Nachrichten abonnieren
+//   Daemon -> Client:  "OK\n" / "FAIL\n"        Nachricht über den Link bestätigt
+//                      "MSG <n> <kanal>\n" + n Bytes   Empfangene Nachricht (Abonnenten)
+//                      "ERR <text>\n"           Protokollfehler, danach Verbindung zu
+//
+// Pro virtuellem Kanal (0..MAX_CHANNELS-1, default 0) gibt es eine
+// Warteschlange in Reihenfolge der Ankunft. Der Link holt Frames mit
+// next_frame(): immer vom Kanal mit der kleinsten Nummer, der etwas hat
+// (strikte Priorität). Eine lange Übertragung auf Kanal 7 wird so an der
+// nächsten Frame-Grenze von einer kurzen Nachricht auf Kanal 0 überholt.
+//
+// Sind insgesamt max_queue_bytes ungesendet, liest der Daemon von den
+// Sendern nichts mehr, bis wieder Platz ist; der Client blockiert dann in
+// seinem write(). Abonnenten, die mehr als max_queue_bytes im Rückstand
+// sind, werden getrennt statt unbegrenzt zu puffern.
+//
+// Nur für POSIX-Systeme; unter Windows liefert start() einen Fehler.
+class LinkDaemon
+{
+public:
+    explicit LinkDaemon(const std::string &socket_path, size_t max_queue_bytes = 16 << 20);
+    ~LinkDaemon(); // stop()
+
+    // Legt den Socket an und startet den Client-Thread. false mit Meldung
+    // in error, z.B. wenn schon ein Daemon auf dem Socket läuft.
+    bool start(std::string &error);
+    void stop();
+    bool running() const { return listen_fd >= 0 && !stopping; }
+
+    // Link-Seite (TX): nächster Frame nach Priorität, false nach
+    // timeout_ms ohne einen
+    bool next_frame(OutgoingFrame &frame, int timeout_ms);
+    // Nach dem letzten Frame (oder einem Fehler) an den Client melden. Bei
+    // Fehler wird der Rest der Nachricht verworfen.
+    void sent(const OutgoingFrame &frame, bool success);
+    // Link neu aufgesetzt: angefangene Nachrichten mit FAIL verwerfen
+    void abort_started();
+
+    // Link-Seite (RX): an alle Abonnenten verteilen
+    void deliver(int channel, const ByteSpan &message);
+
+    size_t queued_bytes();
+
+private:
+    struct PendingMessage
+    {
+        uint64_t client;
+        uint64_t id;
+        std::vector<uint8_t> data;
+        size_t offset; // Bereits an den Link gegeben
+    };
+
+    struct Client
+    {
+        int fd;
+        bool subscriber;
+        bool closing;        // Nach dem Leeren von output schließen
+        std::string input;   // Noch nicht verarbeitete Bytes
+        std::string output;  // Noch nicht geschriebene Antworten
+        size_t expect;       // Länge der laufenden SEND-Nachricht
+        int channel;         // Kanal der laufenden SEND-Nachricht
+        bool in_body;
+    };
+
+    std::string socket_path;
+    size_t max_queue_bytes;
+    int listen_fd;
+    int wake_pipe[2];
+    volatile bool stopping;
+
+    std::mutex mtx;
+    std::condition_variable outgoing_ready;
+    std::map<uint64_t, Client> clients;
+    uint64_t next_client_id;
+    uint64_t next_message_id;
+    std::deque<PendingMessage> outgoing[MAX_CHANNELS];
+    size_t outgoing_bytes; // Noch nicht an den Link gegeben
+    std::thread worker;
+
+    void run();
+    void wake();
+    void accept_clients();
+    bool read_client(uint64_t id, Client &client);
+    bool parse_input(uint64_t id, Client &client);
+    bool write_client(Client &client);
+    void close_client(Client &client);
+    void fail_message(std::deque<PendingMessage> &queue, size_t index);
+
+    LinkDaemon(const LinkDaemon &) = delete;
+    LinkDaemon &operator=(const LinkDaemon &) = delete;
+};
+
+// Standardpfad des Sockets für ein Board, z.B. "b15link_A.sock"
+std::string default_daemon_socket(const std::string &board);
+
+// Clients für die Kommandozeile, Rückgabe ist der Exit-Code.
+// submit: jede Zeile von stdin ist eine Nachricht (ohne '\n') auf channel
+int run_daemon_submit(const std::string &socket_path, int channel = 0);
+// subscribe: jede empfangene Nachricht auf stdout, im Format des Daemons
+// ("MSG <n> <kanal>\n" + n Bytes), damit sich auch Nachrichten mit '\n' trennen lassen
+int run_daemon_subscribe(const std::string &socket_path);
+
+#endif // LINK_DAEMON_H
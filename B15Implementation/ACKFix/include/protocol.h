@@ -1,6 +1,7 @@
 #ifndef PROTOCOL_H
 #define PROTOCOL_H
 
+#include <cstddef>
 #include <cstdint>
 
 // Protocol Constants
@@ -8,8 +9,185 @@ const uint8_t ACK_BYTE = 0x06;     // ASCII ACK
 const uint8_t NACK_BYTE = 0x15;    // ASCII NAK
 const uint8_t EOT_BYTE = 0x04;     // ASCII EOT (End of Transmission)
 const uint8_t NO_DATA_BYTE = 0x10; // signals "no data to send"
+const uint8_t END_BYTE = 0x17;     // ASCII ETB: Eingabe zu Ende, danach nur noch NO_DATA
 const int MAX_RETRIES = 5;
 
+// Credit-Flusskontrolle: Ein Empfänger, dessen Verbraucher (Datei, Pipe)
+// hinterherhinkt, bestätigt statt mit ACK_BYTE mit ACK_FULL, sobald weniger
+// als CREDIT_UNIT Bytes im Empfangsfenster frei sind. Der Sender hält dann vor
+// dem nächsten Nutzdaten-Byte an und fragt alle probe_interval_ms mit
+// PROBE_BYTE nach, bis wieder ACK_BYTE kommt. Das zählt weder als Fehler noch
+// als Wiederholung. ACK_FULL liegt mindestens 6 Bit von ACK_BYTE und
+// NACK_BYTE entfernt, ein gekipptes Bit macht aus einem NACK also kein ACK.
+// Empfänger ohne Fenster senden nur ACK_BYTE und bleiben kompatibel.
+const uint8_t ACK_FULL = 0xE8;
+const size_t CREDIT_UNIT = 256;
+const uint8_t PROBE_BYTE = 0x11; // ASCII DC1 (XON)
+
+inline uint8_t credit_ack(size_t free_bytes)
+{
+    return free_bytes < CREDIT_UNIT ? ACK_FULL : ACK_BYTE;
+}
+
+inline bool is_ack(uint8_t response)
+{
+    return response == ACK_BYTE || response == ACK_FULL;
+}
+
+// Freier Platz laut Bestätigung: 0 = Fenster voll, -1 = unbegrenzt
+inline long ack_credit(uint8_t response)
+{
+    return response == ACK_FULL ? 0 : -1;
+}
+
+// Byte-Stuffing für Nutzdaten: Bytes, die der Empfänger als EOT, NO_DATA, Ende, Kanalwechsel,
+// Abbruch, Probe oder als Fehlerwert 0xFF von receive_byte_with_checksum() lesen würde, gehen als
+// ESC_BYTE gefolgt von byte ^ ESC_XOR über die Leitung. Damit lassen sich
+// beliebige Binärdaten übertragen.
+const uint8_t ESC_BYTE = 0x1B; // ASCII ESC
+const uint8_t ESC_XOR = 0x20;
+
+// Virtuelle Kanäle: CHANNEL_BYTE gefolgt von der Kanalnummer (maskiert wie
+// Nutzdaten) schaltet um; folgende Nutzdaten und das nächste EOT gehören
+// zu diesem Kanal. Ohne Umschaltung gilt Kanal 0, Sender ohne Kanäle
+// bleiben also kompatibel. Ein Sender wechselt den Kanal nur an
+// Frame-Grenzen, d.h. nach höchstens FRAME_BYTES Nutzdaten.
+const uint8_t CHANNEL_BYTE = 0x1C; // ASCII FS (File Separator)
+const int MAX_CHANNELS = 8;        // 0 = höchste Priorität
+const size_t FRAME_BYTES = 64;
+
+// Abbruch statt EOT: Scheitert ein Byte mitten in einer Nachricht (oder
+// zwischen ESC bzw. CHANNEL_BYTE und dem folgenden Byte), sendet der Sender
+// vor allem anderen ABORT_BYTE und verwirft seine angefangenen Nachrichten.
+// Der Empfänger verwirft daraufhin alle Teilnachrichten, setzt Unstuffer und
+// ChannelTracker zurück (wieder Kanal 0) und liefert nichts aus.
+const uint8_t ABORT_BYTE = 0x18; // ASCII CAN (Cancel)
+
+inline bool needs_escape(uint8_t byte)
+{
+    return byte == EOT_BYTE || byte == NO_DATA_BYTE || byte == END_BYTE || byte == ESC_BYTE || byte == CHANNEL_BYTE || byte == PROBE_BYTE ||
+           byte == ABORT_BYTE || byte == 0xFF;
+}
+
+// Wire-Bytes für ein Nutzdaten-Byte, Rückgabe 1 oder 2
+inline int stuff_byte(uint8_t byte, uint8_t wire[2])
+{
+    if (!needs_escape(byte))
+    {
+        wire[0] = byte;
+        return 1;
+    }
+    wire[0] = ESC_BYTE;
+    wire[1] = byte ^ ESC_XOR;
+    return 2;
+}
+
+// Wire-Bytes für die Umschaltung auf channel, Rückgabe 2 oder 3
+inline int channel_switch(int channel, uint8_t wire[3])
+{
+    wire[0] = CHANNEL_BYTE;
+    return 1 + stuff_byte((uint8_t)channel, wire + 1);
+}
+
+// Gegenstück beim Empfänger, ein Objekt pro Empfangsrichtung
+class Unstuffer
+{
+public:
+    enum Kind
+    {
+        PENDING, // ESC gelesen, das eigentliche Byte folgt noch; oder PROBE_BYTE
+        PAYLOAD, // Nutzdaten-Byte (ggf. zurückgewandelt)
+        CONTROL  // unmaskiertes Steuerzeichen, z.B. EOT_BYTE
+    };
+
+    Unstuffer() : escaped(false) {}
+
+    Kind feed(uint8_t &byte)
+    {
+        // Kein maskiertes Byte ergibt ABORT_BYTE, ein angefangenes ESC ist
+        // damit hinfällig
+        if (byte == ABORT_BYTE)
+        {
+            escaped = false;
+            return CONTROL;
+        }
+        if (escaped)
+        {
+            escaped = false;
+            byte ^= ESC_XOR;
+            return PAYLOAD;
+        }
+        if (byte == ESC_BYTE)
+        {
+            escaped = true;
+            return PENDING;
+        }
+        if (byte == PROBE_BYTE)
+        {
+            return PENDING; // Nur Nachfrage nach Credit, schon beantwortet
+        }
+        return needs_escape(byte) ? CONTROL : PAYLOAD;
+    }
+
+private:
+    bool escaped;
+};
+
+// Kanalwechsel beim Empfänger, nach dem Unstuffer aufrufen. false, wenn
+// das Byte zur Umschaltung gehört und nicht weiterverarbeitet wird.
+class ChannelTracker
+{
+public:
+    ChannelTracker() : channel(0), expect_id(false) {}
+
+    bool feed(Unstuffer::Kind kind, uint8_t byte)
+    {
+        if (kind == Unstuffer::CONTROL && byte == ABORT_BYTE)
+        {
+            channel = 0;
+            expect_id = false;
+            return true; // Der Aufrufer verwirft die Teilnachrichten
+        }
+        if (expect_id)
+        {
+            expect_id = false;
+            channel = byte % MAX_CHANNELS;
+            return false;
+        }
+        if (kind == Unstuffer::CONTROL && byte == CHANNEL_BYTE)
+        {
+            expect_id = true;
+            return false;
+        }
+        return true;
+    }
+
+    int current() const { return channel; }
+
+private:
+    int channel;
+    bool expect_id;
+};
+
+// Empfangsfenster für die Credit-Flusskontrolle
+struct FlowSettings
+{
+    size_t rx_window;      // Bytes, die der Verbraucher im Rückstand sein darf, 0 = aus
+                           // (Default, ältere Sender kennen ACK_FULL nicht)
+    int probe_interval_ms; // Pause zwischen zwei PROBE_BYTEs bei vollem Fenster
+
+    FlowSettings() : rx_window(0), probe_interval_ms(20) {}
+};
+
+// Puffer zwischen Empfänger und Verbraucher, z.B. GroupCommitWriter. Sein
+// Rückstand bestimmt den Credit in den Bestätigungen.
+class BacklogSource
+{
+public:
+    virtual ~BacklogSource() {}
+    virtual size_t backlog() = 0; // Angenommen, aber noch nicht abgeholt
+};
+
 // Bit-Masken für die 2-Bit Kommunikation
 const uint8_t DATA0 = 0x01;
 const uint8_t DATA1 = 0x02;
@@ -0,0 +1,57 @@
+#ifndef RAW_OUTPUT_H
+#define RAW_OUTPUT_H
+
+#include "protocol.h"
+#include "spsc_ring.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+// Empfangene Nutzdaten unverändert auf einen Dateideskriptor (meist stdout),
+// z.B. für "simulator B receive --raw | tar x". write() legt die Bytes nur in
+// einen Ring; ein eigener Thread schreibt blockweise, sobald ein Block voll
+// ist, flush() kommt oder Daten 100 ms liegen, nie pro Byte oder pro Zeile.
+// Dazwischen schläft er, bis write() oder flush() ihn weckt.
+// Eine langsame Pipe hält so nicht mehr den Empfang auf, sondern lässt nur
+// backlog() wachsen, und der Empfänger bremst den Sender über die Credits
+// (siehe protocol.h).
+// Unter Windows im Binärmodus, damit aus '\n' kein "\r\n" wird.
+class RawOutput : public BacklogSource
+{
+public:
+    explicit RawOutput(int fd = 1, size_t capacity = 1 << 20);
+    ~RawOutput(); // Schreibt den Rest
+
+    // Legt len Bytes am Stück in den Ring. Wartet nur, wenn er voll ist,
+    // d.h. wenn der Sender die Credits nicht beachtet.
+    void write(const uint8_t *data, size_t len);
+
+    // Bisheriges ausgeben lassen, ohne darauf zu warten
+    void flush();
+
+    // false, sobald das Ziel nicht mehr schreibbar ist (z.B. Pipe geschlossen)
+    bool ok() const { return !failed.load(std::memory_order_acquire); }
+
+    size_t backlog() { return ring.size(); }
+
+private:
+    int fd;
+    SpscByteRing ring;
+    std::atomic<bool> flush_requested;
+    std::atomic<bool> closing;
+    std::atomic<bool> failed;
+    RingSignal data_ready;  // Weckt den Schreiber: erste Daten, flush() oder Ende
+    RingSignal flush_due;   // Weckt ihn früher als nach 100 ms: Block voll, flush() oder Ende
+    RingSignal space_ready; // Weckt write(), wenn der Ring voll war
+    std::thread writer;
+
+    void run();
+    void write_all(const uint8_t *data, size_t len);
+    void wait_for_room();
+
+    RawOutput(const RawOutput &) = delete;
+    RawOutput &operator=(const RawOutput &) = delete;
+};
+
+#endif // RAW_OUTPUT_H
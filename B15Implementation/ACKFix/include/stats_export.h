@@ -0,0 +1,46 @@
+#ifndef STATS_EXPORT_H
+#define STATS_EXPORT_H
+
+#include "stats.h"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Schreibt periodisch Momentaufnahmen einer Stats-Instanz als
+//   <prefix>.json  - Zähler, Raten, Histogramme
+//   <prefix>.csv   - eine Zeile "metric,value" pro Wert (gut zum Diffen)
+//   <prefix>.prom  - Prometheus Text-Format (node-exporter textfile collector)
+// Jede Datei wird erst als .tmp geschrieben und dann umbenannt, Leser sehen
+// also nie eine halb geschriebene Datei.
+class StatsExporter
+{
+public:
+    StatsExporter(const Stats &s, const std::string &path_prefix, const std::string &board);
+    ~StatsExporter(); // Stoppt den Thread und schreibt eine letzte Momentaufnahme
+
+    void start(int interval_ms);
+    void stop();
+    bool write_snapshot();
+
+private:
+    const Stats &stats;
+    std::string prefix;
+    std::string board_name;
+
+    std::thread worker;
+    std::mutex mtx;
+    std::mutex write_mutex; // Schützt last/last_ns
+    std::condition_variable wakeup;
+    bool stopping;
+    int interval_ms;
+
+    uint64_t start_ns;
+    uint64_t last_ns;
+    StatsSnapshot last;
+
+    void run();
+};
+
+#endif // STATS_EXPORT_H
@@ -0,0 +1,110 @@
+#ifndef USDT_H
+#define USDT_H
+
+#include <cstdint>
+
+// Statische Tracepoints (USDT) im Format von <sys/sdt.h>, ohne systemtap-dev.
+// Jeder Probe legt ein nop und einen Eintrag in .note.stapsdt an; bpftrace,
+// perf und bcc finden ihn dort, ohne dass neu gebaut werden muss:
+//
+//   bpftrace -l 'usdt:./build/b15comm:b15:*'
+//   bpftrace -e 'usdt:./build/b15comm:b15:byte_tx { @ns = hist(arg2); }'
+//
+// Jeder Probe hat einen Semaphor, den der Tracer beim Anhängen erhöht.
+// Ohne Tracer kostet ein Probe daher nur einen Load und einen nicht
+// genommenen Sprung, die Argumente werden gar nicht erst ausgewertet.
+// Alle Argumente werden als uint64_t übergeben (arg0, arg1, ...).
+//
+// Nur ELF auf x86-64 und AArch64 mit GCC/Clang, sonst leere Makros.
+//
+// Semaphore werden pro Übersetzungseinheit mit B15_PROBE_SEMAPHORE(name)
+// angelegt, vor der ersten Verwendung von B15_PROBEn(name, ...).
+
+#if defined(__ELF__) && (defined(__x86_64__) || defined(__aarch64__)) && defined(__GNUC__)
+#define B15_USDT 1
+#endif
+
+#ifdef B15_USDT
+
+// Der asm-Name verhindert, dass C++ den statischen Namen verändert (_ZL...)
+#define B15_PROBE_SEMAPHORE(name)                                   \
+    static volatile unsigned short b15_##name##_semaphore           \
+        __asm__("b15_" #name "_semaphore")                          \
+        __attribute__((used, section(".probes"))) = 0
+
+#define B15_PROBE_ENABLED(name) __builtin_expect(b15_##name##_semaphore != 0, 0)
+
+// Aufbau wie _SDT_ASM_BODY in sys/sdt.h (Note-Typ 3)
+#define B15_SDT_NOTE(name, args)                                    \
+    "990: nop\n"                                                    \
+    ".pushsection .note.stapsdt,\"?\",\"note\"\n"                   \
+    ".balign 4\n"                                                   \
+    ".4byte 992f-991f, 994f-993f, 3\n"                              \
+    "991: .asciz \"stapsdt\"\n"                                     \
+    "992: .balign 4\n"                                              \
+    "993: .8byte 990b\n"                                            \
+    ".8byte _.stapsdt.base\n"                                       \
+    ".8byte b15_" #name "_semaphore\n"                              \
+    ".asciz \"b15\"\n"                                              \
+    ".asciz \"" #name "\"\n"                                        \
+    ".asciz \"" args "\"\n"                                         \
+    "994: .balign 4\n"                                              \
+    ".popsection\n"                                                 \
+    ".ifndef _.stapsdt.base\n"                                      \
+    ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+    ".weak _.stapsdt.base\n"                                        \
+    ".hidden _.stapsdt.base\n"                                      \
+    "_.stapsdt.base: .space 1\n"                                    \
+    ".size _.stapsdt.base, 1\n"                                     \
+    ".popsection\n"                                                 \
+    ".endif\n"
+
+#define B15_PROBE_ARG(x) "nor"((uint64_t)(x))
+
+#define B15_PROBE1(name, a1)                                                    \
+    do                                                                          \
+    {                                                                           \
+        if (B15_PROBE_ENABLED(name))                                            \
+            __asm__ __volatile__(B15_SDT_NOTE(name, "8@%0")                     \
+                                 : : B15_PROBE_ARG(a1));                        \
+    } while (0)
+
+#define B15_PROBE2(name, a1, a2)                                                \
+    do                                                                          \
+    {                                                                           \
+        if (B15_PROBE_ENABLED(name))                                            \
+            __asm__ __volatile__(B15_SDT_NOTE(name, "8@%0 8@%1")                \
+                                 : : B15_PROBE_ARG(a1), B15_PROBE_ARG(a2));     \
+    } while (0)
+
+#define B15_PROBE3(name, a1, a2, a3)                                            \
+    do                                                                          \
+    {                                                                           \
+        if (B15_PROBE_ENABLED(name))                                            \
+            __asm__ __volatile__(B15_SDT_NOTE(name, "8@%0 8@%1 8@%2")           \
+                                 : : B15_PROBE_ARG(a1), B15_PROBE_ARG(a2),      \
+                                   B15_PROBE_ARG(a3));                          \
+    } while (0)
+
+#define B15_PROBE4(name, a1, a2, a3, a4)                                        \
+    do                                                                          \
+    {                                                                           \
+        if (B15_PROBE_ENABLED(name))                                            \
+            __asm__ __volatile__(B15_SDT_NOTE(name, "8@%0 8@%1 8@%2 8@%3")      \
+                                 : : B15_PROBE_ARG(a1), B15_PROBE_ARG(a2),      \
+                                   B15_PROBE_ARG(a3), B15_PROBE_ARG(a4));       \
+    } while (0)
+
+#else
+
+#define B15_PROBE_SEMAPHORE(name) static_assert(true, "")
+#define B15_PROBE_ENABLED(name) false
+// sizeof wertet nicht aus, vermeidet aber Warnungen zu unbenutzten Variablen
+#define B15_PROBE1(name, a1) do { (void)sizeof(a1); } while (0)
+#define B15_PROBE2(name, a1, a2) do { (void)sizeof((a1, a2)); } while (0)
+#define B15_PROBE3(name, a1, a2, a3) do { (void)sizeof((a1, a2, a3)); } while (0)
+#define B15_PROBE4(name, a1, a2, a3, a4) do { (void)sizeof((a1, a2, a3, a4)); } while (0)
+
+#endif // B15_USDT
+
+#endif // USDT_H
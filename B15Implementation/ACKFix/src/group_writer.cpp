@@ -0,0 +1,294 @@
+#include "../include/group_writer.h"
+#include "../include/histogram.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <iterator>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#if !defined(_WIN32) && !defined(IOV_MAX)
+#define IOV_MAX 1024
+#endif
+
+bool parse_fsync_policy(const string &name, FsyncPolicy &policy)
+{
+    if (name == "none")
+        policy = FSYNC_NONE;
+    else if (name == "periodic")
+        policy = FSYNC_PERIODIC;
+    else if (name == "batch")
+        policy = FSYNC_BATCH;
+    else
+        return false;
+    return true;
+}
+
+GroupCommitWriter::GroupCommitWriter(const WriterSettings &s)
+    : settings(s), fd(-1), stats(&global_stats), pending_bytes(0), writing_bytes(0), stopping(false),
+      write_failed(false), last_fsync_ns(0), unsynced(false)
+{
+}
+
+GroupCommitWriter::~GroupCommitWriter()
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    if (worker.joinable())
+        worker.join();
+
+    if (fd >= 0)
+    {
+        flush();
+        size_t lost = backlog();
+        if (lost > 0)
+        {
+            cerr << "[WRITER] " << lost << " Bytes konnten nicht geschrieben werden" << endl;
+        }
+        // Beim Beenden den Rest des Intervalls nicht abwarten
+        if (settings.fsync_policy == FSYNC_PERIODIC && unsynced)
+        {
+            sync_file();
+        }
+#ifdef _WIN32
+        _close(fd);
+#else
+        close(fd);
+#endif
+    }
+}
+
+bool GroupCommitWriter::open(const string &path, string &error)
+{
+#ifdef _WIN32
+    fd = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, 0644);
+#else
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif
+    if (fd < 0)
+    {
+        error = "Ausgabedatei nicht beschreibbar: " + path + " (" + strerror(errno) + ")";
+        return false;
+    }
+
+    last_fsync_ns = latency_now_ns();
+    worker = thread(&GroupCommitWriter::run, this);
+    return true;
+}
+
+void GroupCommitWriter::append(const ByteSpan &message)
+{
+    bool full;
+    {
+        lock_guard<mutex> lock(mtx);
+        if (spare.empty())
+        {
+            pending.push_back(string());
+        }
+        else
+        {
+            pending.push_back(move(spare.back()));
+            spare.pop_back();
+        }
+
+        string &line = pending.back();
+        line.assign((const char *)message.data, message.size);
+        line += '\n';
+
+        pending_bytes += line.size();
+        full = pending_bytes >= settings.max_batch_bytes;
+    }
+    if (full)
+        wakeup.notify_one();
+}
+
+void GroupCommitWriter::flush()
+{
+    write_batch();
+}
+
+size_t GroupCommitWriter::backlog()
+{
+    lock_guard<mutex> lock(mtx);
+    return pending_bytes + writing_bytes;
+}
+
+void GroupCommitWriter::run()
+{
+    unique_lock<mutex> lock(mtx);
+    while (!stopping)
+    {
+        // Nach einem Schreibfehler das volle Intervall warten, sonst würde
+        // ein voller Batch sofort wieder gegen die Platte laufen
+        wakeup.wait_for(lock, chrono::milliseconds(settings.flush_interval_ms),
+                        [&] { return stopping || (!write_failed && pending_bytes >= settings.max_batch_bytes); });
+
+        lock.unlock();
+        write_batch();
+        lock.lock();
+    }
+}
+
+// Holt den aktuellen Batch und schreibt ihn. Während des Schreibens kann
+// append() schon den nächsten füllen.
+void GroupCommitWriter::write_batch()
+{
+    lock_guard<mutex> write_lock(write_mtx);
+    {
+        lock_guard<mutex> lock(mtx);
+        writing.swap(pending);
+        writing_bytes = pending_bytes;
+        pending_bytes = 0;
+    }
+
+    if (fd >= 0 && !writing.empty())
+    {
+        size_t written = 0; // Ab Batch-Anfang
+        int error = 0;
+#ifdef _WIN32
+        // Kein writev: ein Puffer, kurze Schreibvorgänge bis zum Ende nachschieben
+        string joined;
+        for (size_t i = 0; i < writing.size(); i++)
+            joined += writing[i];
+        while (written < joined.size())
+        {
+            int n = _write(fd, joined.data() + written, (unsigned)(joined.size() - written));
+            if (n <= 0)
+            {
+                error = n < 0 ? errno : EIO;
+                break;
+            }
+            written += (size_t)n;
+        }
+#else
+        // Bis zu IOV_MAX Nachrichten pro writev(); kurze Schreibvorgänge
+        // bis zum Ende nachschieben
+        vector<iovec> iov;
+        iov.reserve(min(writing.size(), (size_t)IOV_MAX));
+        for (size_t start = 0; start < writing.size() && error == 0; start += IOV_MAX)
+        {
+            size_t end = min(writing.size(), start + (size_t)IOV_MAX);
+            iov.clear();
+            for (size_t i = start; i < end; i++)
+            {
+                iovec v;
+                v.iov_base = (void *)writing[i].data();
+                v.iov_len = writing[i].size();
+                iov.push_back(v);
+            }
+
+            size_t first = 0;
+            while (first < iov.size())
+            {
+                ssize_t n = writev(fd, &iov[first], (int)(iov.size() - first));
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0)
+                {
+                    error = n < 0 ? errno : EIO;
+                    break;
+                }
+
+                written += (size_t)n;
+                size_t rest = (size_t)n;
+                while (first < iov.size() && rest >= iov[first].iov_len)
+                    rest -= iov[first++].iov_len;
+                if (first < iov.size())
+                {
+                    iov[first].iov_base = (char *)iov[first].iov_base + rest;
+                    iov[first].iov_len -= rest;
+                }
+            }
+        }
+#endif
+        if (written > 0)
+            unsynced = true;
+
+        if (error != 0)
+        {
+            stats->local().write_errors++;
+            if (!write_failed)
+            {
+                cerr << "[WRITER] Schreiben fehlgeschlagen: " << strerror(error)
+                     << " (wird alle " << settings.flush_interval_ms << " ms wiederholt)" << endl;
+            }
+            requeue_unwritten(written);
+            return;
+        }
+        if (write_failed)
+        {
+            cerr << "[WRITER] Schreiben wieder erfolgreich" << endl;
+        }
+
+        // Strings behalten ihre Kapazität für die nächsten append()-Aufrufe;
+        // einzelne Riesen-Nachrichten nicht dauerhaft festhalten
+        lock_guard<mutex> lock(mtx);
+        write_failed = false;
+        for (size_t i = 0; i < writing.size(); i++)
+        {
+            if (writing[i].capacity() > settings.max_batch_bytes)
+                continue;
+            writing[i].clear();
+            spare.push_back(move(writing[i]));
+        }
+        writing.clear();
+        writing_bytes = 0;
+    }
+
+    // Periodisch auch ohne neue Daten, sonst bliebe der letzte Batch
+    // ungesichert, bis wieder etwas ankommt
+    uint64_t now_ns = latency_now_ns();
+    bool sync = settings.fsync_policy == FSYNC_BATCH ||
+                (settings.fsync_policy == FSYNC_PERIODIC &&
+                 now_ns - last_fsync_ns >= (uint64_t)settings.fsync_interval_ms * 1000000);
+    if (unsynced && sync)
+    {
+        sync_file();
+        last_fsync_ns = now_ns;
+    }
+}
+
+// Nach einem Schreibfehler: die ersten written Bytes des Batches sind in
+// der Datei, der Rest kommt vor die inzwischen angehängten Nachrichten
+void GroupCommitWriter::requeue_unwritten(size_t written)
+{
+    size_t first = 0;
+    while (first < writing.size() && written >= writing[first].size())
+        written -= writing[first++].size();
+    if (first < writing.size())
+        writing[first].erase(0, written);
+
+    lock_guard<mutex> lock(mtx);
+    size_t rest = 0;
+    for (size_t i = first; i < writing.size(); i++)
+        rest += writing[i].size();
+    pending.insert(pending.begin(), make_move_iterator(writing.begin() + first),
+                   make_move_iterator(writing.end()));
+    pending_bytes += rest;
+    writing.clear();
+    writing_bytes = 0;
+    write_failed = true;
+}
+
+void GroupCommitWriter::sync_file()
+{
+#ifdef _WIN32
+    _commit(fd);
+#else
+    fsync(fd);
+#endif
+    unsynced = false;
+}
@@ -0,0 +1,53 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Log-lineares Latenz-Histogramm (Prinzip wie HdrHistogram):
+// 16 lineare Unter-Buckets pro Zweierpotenz, also max. 6.25% relativer Fehler
+// über den gesamten uint64-Bereich. Feste Bucket-Anzahl, record() allokiert
+// nicht und ist ohne Lock threadsicher.
+class LatencyHistogram
+{
+public:
+    static const int SUB_BUCKET_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    LatencyHistogram();
+
+    void record(uint64_t value_ns);
+    void reset();
+    void merge(const LatencyHistogram &other); // Werte von other hinzufügen
+
+    uint64_t count() const;
+    uint64_t max() const;
+    double mean() const;
+    uint64_t percentile(double p) const; // p in Prozent, z.B. 99.9
+
+    // Eine Zeile mit p50/p90/p99/p99.9/max, standardmäßig in Mikrosekunden
+    void print(const std::string &label, double divisor = 1000.0,
+               const std::string &unit = "us") const;
+
+private:
+    std::atomic<uint64_t> counts[BUCKETS];
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> max_value;
+
+    static int bucket_index(uint64_t value);
+    static uint64_t bucket_upper_value(int index);
+};
+
+// Monotone Zeit in Nanosekunden für Latenzmessungen
+inline uint64_t latency_now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+#endif // HISTOGRAM_H
@@ -0,0 +1,59 @@
+#ifndef INPUT_STREAM_H
+#define INPUT_STREAM_H
+
+#include "spsc_ring.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+// Liest eine Eingabe (default stdin) in einem eigenen Thread blockweise in
+// einen SpscByteRing fester Größe. Ist der Ring voll, wartet der Leser; der
+// Speicherbedarf bleibt also bei jeder Eingabegröße gleich. read() liefert,
+// sobald überhaupt Daten da sind, das erste Byte geht damit sofort raus und
+// nicht erst, wenn die ganze Eingabe oder eine ganze Zeile gelesen ist.
+// Die Bytes werden unverändert weitergegeben, auch Binärdaten.
+//
+// Der Datenweg ist lock-frei. Wer warten muss (Ring leer bzw. voll), schläft
+// in einem RingSignal, bis die Gegenseite ihn weckt; ein ruhender Link
+// kostet also keine Wakeups.
+class InputStream
+{
+public:
+    explicit InputStream(int fd = 0, size_t capacity = 1 << 20);
+    ~InputStream();
+
+    // Kopiert bis zu max Bytes nach dst und wartet, falls noch nichts da ist.
+    // 0 = Eingabe zu Ende (EOF oder Lesefehler) und alles abgeholt.
+    size_t read(uint8_t *dst, size_t max);
+
+    // Wie read(), wartet aber nicht. 0 und eof = false: gerade nichts da,
+    // die Eingabe läuft aber noch (z.B. Pipe, deren Quelle pausiert)
+    size_t try_read(uint8_t *dst, size_t max, bool &eof);
+
+    // Gelesene, noch nicht abgeholte Bytes (Momentaufnahme)
+    size_t buffered() const;
+
+private:
+    struct State
+    {
+        SpscByteRing ring;
+        std::atomic<bool> finished; // Leser fertig, danach kommt nichts mehr in den Ring
+        std::atomic<bool> closing;
+        RingSignal data_ready;  // Weckt den Verbraucher: neue Daten oder Ende
+        RingSignal space_ready; // Weckt den Leser: Platz frei oder closing
+
+        explicit State(size_t capacity) : ring(capacity), finished(false), closing(false) {}
+    };
+
+    // Geteilt mit dem Leser-Thread: hängt dieser beim Zerstören noch in
+    // einem blockierenden read() (z.B. Terminal), wird er abgehängt und
+    // räumt den Zustand selbst auf
+    std::shared_ptr<State> state;
+    std::thread reader;
+
+    static void run(std::shared_ptr<State> state, int fd);
+};
+
+#endif // INPUT_STREAM_H
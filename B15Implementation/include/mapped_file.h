@@ -0,0 +1,38 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Datei schreibgeschützt in den Adressraum eingeblendet (mmap bzw.
+// MapViewOfFile unter Windows). Der Sender liest die Bytes direkt aus dem
+// Page Cache, ohne iostream-Puffer und ohne Kopie in den User-Space.
+// Unter Linux mit MADV_SEQUENTIAL: der Kernel liest aggressiv voraus und
+// gibt gelesene Seiten früher wieder frei.
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    // false mit Fehlermeldung in error, z.B. wenn die Datei fehlt
+    bool load(const std::string &path, std::string &error);
+
+    const uint8_t *data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const uint8_t *bytes;
+    size_t length;
+#ifdef _WIN32
+    void *mapping; // HANDLE der File-Mapping
+#endif
+
+    void unmap();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+};
+
+#endif // MAPPED_FILE_H
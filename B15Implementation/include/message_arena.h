@@ -0,0 +1,150 @@
+#ifndef MESSAGE_ARENA_H
+#define MESSAGE_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Ansicht auf Bytes, die jemand anderem gehören (wie std::string_view,
+// das es in C++11 noch nicht gibt). Nur gültig, solange der Besitzer die
+// Daten nicht verändert.
+struct ByteSpan
+{
+    const uint8_t *data;
+    size_t size;
+
+    ByteSpan() : data(nullptr), size(0) {}
+    ByteSpan(const uint8_t *d, size_t n) : data(d), size(n) {}
+
+    std::string str() const { return std::string((const char *)data, size); }
+};
+
+// Schreibt die Bytes unverändert, ohne Zwischenstring
+inline std::ostream &operator<<(std::ostream &out, const ByteSpan &span)
+{
+    return out.write((const char *)span.data, span.size);
+}
+
+// Ab welcher Größe eine Nachricht nicht mehr im Speicher gehalten wird
+struct SpillSettings
+{
+    size_t memory_limit;   // Bytes pro Nachricht im Speicher, 0 = unbegrenzt
+    std::string directory; // Ziel der Spill-Dateien
+
+    SpillSettings() : memory_limit(64 << 20), directory(".") {}
+};
+
+// Größen wie "65536", "512K" oder "64M"; false bei ungültiger Angabe, Vorzeichen
+// oder Werten, die nicht in size_t passen
+bool parse_byte_size(const std::string &text, size_t &bytes);
+
+// Ausgelagerte Nachricht. Die Datei gehört nach take_spill() dem Aufrufer.
+struct SpillFile
+{
+    std::string path;
+    uint64_t size;
+    uint64_t dropped; // Nicht gespeichert, weil die Datei nicht schreibbar war
+};
+
+// Puffer für die Nachricht, die gerade empfangen wird. Er wächst nur, bis
+// er die größte bisher empfangene Nachricht fasst, und wird nach jeder
+// Auslieferung mit reset() wiederverwendet. Im eingeschwungenen Zustand
+// gibt es also keine Heap-Allokation, weder pro Byte noch pro Nachricht.
+//
+// Überschreitet eine Nachricht SpillSettings::memory_limit (z.B. weil nie
+// ein EOT kommt), wird sie in eine Spill-Datei ausgelagert; der Puffer
+// dient dann nur noch als Schreibpuffer. Der Speicherbedarf bleibt so bei
+// jeder Nachrichtengröße unter dem Limit.
+class MessageArena
+{
+public:
+    // tag erscheint im Namen der Spill-Dateien, z.B. "B"
+    explicit MessageArena(const SpillSettings &settings = SpillSettings(), const std::string &tag = "msg");
+    ~MessageArena(); // Löscht eine nicht abgeholte Spill-Datei
+
+    void push(uint8_t byte)
+    {
+        if (length == buffer.size())
+            make_room();
+        buffer[length++] = byte;
+    }
+
+    uint64_t size() const { return spilled_bytes + dropped_bytes + length; }
+    bool empty() const { return size() == 0; }
+
+    // true, sobald die aktuelle Nachricht ausgelagert wurde; dann gibt es
+    // kein view(), sondern nur take_spill()
+    bool spilled() const { return spilling; }
+
+    // Gültig bis zum nächsten push() oder reset(), nur ohne spilled()
+    ByteSpan view() const { return ByteSpan(buffer.data(), length); }
+
+    // Schreibt den Rest, schließt die Datei und übergibt sie dem Aufrufer
+    SpillFile take_spill();
+
+    // Zum Ausgeben: die Nachricht selbst oder, wenn ausgelagert, der Verweis
+    // "[ausgelagert: <pfad>, N Bytes]" in note (die Datei bleibt liegen)
+    ByteSpan take_message(std::string &note);
+
+    // Nachricht ausgeliefert, Speicher bleibt für die nächste
+    void reset();
+
+private:
+    SpillSettings settings;
+    std::string tag;
+    std::vector<uint8_t> buffer;
+    size_t length;
+
+    bool spilling;
+    FILE *spill;
+    std::string spill_path;
+    uint64_t spilled_bytes;
+    uint64_t dropped_bytes;
+
+    void make_room();
+    void write_spill();
+
+    MessageArena(const MessageArena &) = delete;
+    MessageArena &operator=(const MessageArena &) = delete;
+};
+
+// Ein MessageArena pro virtuellem Kanal (siehe CHANNEL_BYTE in protocol.h),
+// angelegt beim ersten Byte auf dem Kanal
+class ChannelArenas
+{
+public:
+    ChannelArenas(const SpillSettings &s, const std::string &t) : settings(s), tag(t) {}
+
+    MessageArena &operator[](int channel)
+    {
+        if ((size_t)channel >= arenas.size())
+            arenas.resize(channel + 1);
+        if (!arenas[channel])
+        {
+            std::string name = channel == 0 ? tag : tag + "_k" + std::to_string(channel);
+            arenas[channel].reset(new MessageArena(settings, name));
+        }
+        return *arenas[channel];
+    }
+
+    // Alle angefangenen Nachrichten verwerfen
+    void reset()
+    {
+        for (size_t i = 0; i < arenas.size(); i++)
+        {
+            if (arenas[i])
+                arenas[i]->reset();
+        }
+    }
+
+private:
+    SpillSettings settings;
+    std::string tag;
+    std::vector<std::unique_ptr<MessageArena>> arenas;
+};
+
+#endif // MESSAGE_ARENA_H
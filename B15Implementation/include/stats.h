@@ -1,17 +1,118 @@
 #ifndef STATS_H
 #define STATS_H
 
+#include "histogram.h"
 #include <atomic>
+#include <cstdint>
+
+// Wofür die Leitung genutzt wurde. Jedes Byte sind 4 Symbole à 2 Bit.
+// Ein Versuch, der mit NACK/Timeout bzw. falscher Checksum endet, zählt
+// komplett (Daten, Checksum, Antwort) als OVERHEAD_RETRANSMIT.
+enum OverheadCategory
+{
+    OVERHEAD_PAYLOAD = 0, // Nutzdaten-Byte
+    OVERHEAD_CHECKSUM,    // Checksum-Byte
+    OVERHEAD_ACK,         // ACK_BYTE/NACK_BYTE-Antwort
+    OVERHEAD_EOT,         // EOT_BYTE bzw. ABORT_BYTE
+    OVERHEAD_NO_DATA,     // NO_DATA_BYTE (Ping-Pong-Modus in ACKFix)
+    OVERHEAD_ESCAPE,      // ESC_BYTE vor maskierten Nutzdaten
+    OVERHEAD_CHANNEL,     // CHANNEL_BYTE (Kanalwechsel)
+    OVERHEAD_PROBE,       // PROBE_BYTE bei vollem Empfangsfenster
+    OVERHEAD_RETRANSMIT,  // Fehlgeschlagene Versuche
+    OVERHEAD_CATEGORIES
+};
+
+const char *overhead_key(int category);   // z.B. "checksum", für Export
+const char *overhead_label(int category); // z.B. "Checksum", für print()
+
+// Momentaufnahme aller Zähler, z.B. für Export und Ratenberechnung
+struct StatsSnapshot
+{
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+    uint64_t payload_sent;
+    uint64_t payload_received;
+    uint64_t retransmissions;
+    uint64_t checksum_errors;
+    uint64_t credit_stalls;
+    uint64_t credit_wait_ns;
+    uint64_t poll_iterations;
+    uint64_t io_time_ns;
+    uint64_t sleep_time_ns;
+    uint64_t sleep_requested_ns;
+    uint64_t near_timeouts;
+    uint64_t symbol_timeouts;
+    uint64_t write_errors;
+    uint64_t overhead_symbols[OVERHEAD_CATEGORIES];
+    uint64_t overhead_ns[OVERHEAD_CATEGORIES];
+};
+
+// Zähler und Histogramme eines Threads. alignas(64) legt jeden Shard auf
+// eigene Cache-Lines, TX- und RX-Thread schreiben im Full-Duplex also nie
+// auf dieselbe Line. Summiert wird erst beim Lesen (Stats::snapshot() bzw.
+// Stats::merged()).
+struct alignas(64) StatsShard
+{
+    std::atomic<uint64_t> bytes_sent{0};
+    std::atomic<uint64_t> bytes_received{0};
+    std::atomic<uint64_t> payload_sent{0};     // Nur Nutzdaten, ohne EOT/ESC/Kanal/Probe
+    std::atomic<uint64_t> payload_received{0}; // dito, empfangen
+    std::atomic<uint64_t> retransmissions{0};
+    std::atomic<uint64_t> checksum_errors{0};
+    std::atomic<uint64_t> credit_stalls{0};  // Pausen, weil die Gegenseite keinen Platz hatte
+    std::atomic<uint64_t> credit_wait_ns{0}; // Davon insgesamt gewartet
+    std::atomic<uint64_t> write_errors{0};   // Fehlgeschlagene Schreibversuche der Ausgabedatei
+
+    // Poll-Effizienz der Handshake-Warteschleifen
+    std::atomic<uint64_t> poll_iterations{0};
+    std::atomic<uint64_t> io_time_ns{0};         // In read_input/write_output (inkl. Mutex)
+    std::atomic<uint64_t> sleep_time_ns{0};      // Tatsächlich geschlafen
+    std::atomic<uint64_t> sleep_requested_ns{0}; // Angeforderte Schlafzeit
+    std::atomic<uint64_t> near_timeouts{0};      // Symbol erst nach >80% des Timeouts
+    std::atomic<uint64_t> symbol_timeouts{0};
+
+    // Symbole und Leitungszeit pro OverheadCategory
+    std::atomic<uint64_t> overhead_symbols[OVERHEAD_CATEGORIES]{};
+    std::atomic<uint64_t> overhead_ns[OVERHEAD_CATEGORIES]{};
+
+    // Latenzen in Nanosekunden, pro Symbol bzw. Poll erfasst
+    LatencyHistogram symbol_tx;        // send_2bits: Symbol anlegen bis ACK-Flanke
+    LatencyHistogram symbol_rx;        // receive_2bits: Warten bis CLOCK-Flanke
+    LatencyHistogram byte_rtt;         // Daten + Checksum senden bis ACK/NACK
+    LatencyHistogram polls_per_symbol; // Anzahl Polls, keine Zeit
+    LatencyHistogram read_io;          // Dauer eines read_input()
+};
 
 class Stats
 {
 public:
-    std::atomic<int> bytes_sent{0};
-    std::atomic<int> bytes_received{0};
-    std::atomic<int> retransmissions{0};
-    std::atomic<int> checksum_errors{0};
+    // Einen Shard bekommt nur, wer local() aufruft, also Main-, TX- und
+    // RX-Thread; Dashboard und Export lesen nur. Ab dem neunten
+    // schreibenden Thread teilen sich Threads wieder einen Shard: die Werte
+    // bleiben richtig, nur die Cache-Lines sind dann wieder geteilt.
+    static const int MAX_SHARDS = 8;
+
+    // Shard des aufrufenden Threads, z.B. global_stats.local().bytes_sent++
+    StatsShard &local();
+    void add_overhead(OverheadCategory category, uint64_t symbols, uint64_t ns); // Über local()
 
+    // Gelesen, aber noch nicht bestätigt (Gauge). Schreibt nur der Sendepfad,
+    // daher nicht geshardet.
+    std::atomic<uint64_t> tx_queue_bytes{0};
+
+    // Erstes Byte bis EOT in Nanosekunden. Einmal pro Nachricht, daher
+    // nicht geshardet; die Histogramme pro Symbol liegen im StatsShard.
+    LatencyHistogram message;
+
+    StatsSnapshot snapshot() const; // Summe über alle Shards
+
+    // Histogramm aller Shards, z.B. merged(&StatsShard::byte_rtt, out)
+    void merged(LatencyHistogram StatsShard::*which, LatencyHistogram &out) const;
+    uint64_t count(LatencyHistogram StatsShard::*which) const; // Ohne zu mergen
     void print();
+
+private:
+    StatsShard shards[MAX_SHARDS];
 };
 
 // Globale Statistik-Instanz
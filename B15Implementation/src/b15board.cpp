@@ -3,8 +3,13 @@
 #include "../include/checksum.h"
 #include "../include/stats.h"
 #include "../include/error_injector.h"
+#include "../include/usdt.h"
+#include "../include/input_stream.h"
+#include "../include/mapped_file.h"
+#include "../include/group_writer.h"
+#include "../include/message_arena.h"
+#include "../include/raw_output.h"
 #include <iostream>
-#include <fstream>
 #include <bitset>
 #include <thread>
 #include <mutex>
@@ -12,6 +17,15 @@
 
 using namespace std;
 
+// USDT-Probes, siehe usdt.h. Argumente:
+B15_PROBE_SEMAPHORE(symbol_tx);   // Ausgangs-Nibble, Polls, ns bis ACK-Flanke
+B15_PROBE_SEMAPHORE(symbol_rx);   // 2 Datenbits, Polls, ns bis CLOCK-Flanke
+B15_PROBE_SEMAPHORE(byte_tx);     // Byte, Wiederholungen, ns, 1 bei ACK
+B15_PROBE_SEMAPHORE(byte_rx);     // Byte, 1 bei gültiger Checksum, ns ab 1. Symbol
+B15_PROBE_SEMAPHORE(retry);       // Byte, Versuch
+B15_PROBE_SEMAPHORE(timeout);     // 0 senden / 1 empfangen, Polls
+B15_PROBE_SEMAPHORE(message_rx);  // Länge in Bytes, ns erstes Byte bis EOT
+
 mutex board_mutex;
 atomic<bool> running(true);
 
@@ -29,6 +43,11 @@ B15Board::B15Board(string board_name, bool verb)
     rx_ack_state = 0;
     rx_last_received_clock = 0;
 
+    rx_consumer = nullptr;
+    tx_credit = -1;
+    tx_channel_id = false;
+    rx_channel_id = false;
+
     drv.delay_ms(200);
 
     // Initialisiere Ausgänge (Bits 0-3)
@@ -45,6 +64,21 @@ B15Board::B15Board(string board_name, bool verb)
     cout << "[" << name << "] DDRA = 0x0F (Bits 0-3: Output, 4-7: Input)" << endl;
 }
 
+void B15Board::set_writer_settings(const WriterSettings &s)
+{
+    writer_settings = s;
+}
+
+void B15Board::set_spill_settings(const SpillSettings &s)
+{
+    spill_settings = s;
+}
+
+void B15Board::set_flow_settings(const FlowSettings &s)
+{
+    flow_settings = s;
+}
+
 void B15Board::set_verbose(bool v)
 {
     verbose = v;
@@ -54,6 +88,7 @@ void B15Board::set_verbose(bool v)
 
 void B15Board::write_output(uint8_t data)
 {
+    uint64_t start_ns = latency_now_ns();
     lock_guard<mutex> lock(board_mutex);
     uint8_t current = drv.getRegister(&PORTA);
     uint8_t new_val = (current & 0xF0) | (data & 0x0F);
@@ -63,10 +98,13 @@ void B15Board::write_output(uint8_t data)
     {
         cout << "  [" << name << "] Write Bits 0-3: " << bitset<4>(data & 0x0F) << endl;
     }
+
+    global_stats.local().io_time_ns += latency_now_ns() - start_ns;
 }
 
 uint8_t B15Board::read_input()
 {
+    uint64_t start_ns = latency_now_ns();
     lock_guard<mutex> lock(board_mutex);
     uint8_t value = drv.getRegister(&PINA);
     uint8_t upper = (value >> 4) & 0x0F; // Lese Bits 7-4
@@ -87,9 +125,37 @@ uint8_t B15Board::read_input()
         cout << "  [" << name << "] Read Bits 7-4 (crossed): " << bitset<4>(crossed) << endl;
     }
 
+    uint64_t elapsed_ns = latency_now_ns() - start_ns;
+    global_stats.local().io_time_ns += elapsed_ns;
+    global_stats.local().read_io.record(elapsed_ns);
+
     return crossed;
 }
 
+void B15Board::poll_sleep()
+{
+    uint64_t start_ns = latency_now_ns();
+    drv.delay_us(100);
+    global_stats.local().sleep_time_ns += latency_now_ns() - start_ns;
+    global_stats.local().sleep_requested_ns += 100000;
+}
+
+void B15Board::record_polls(int polls, bool completed)
+{
+    global_stats.local().poll_iterations += polls;
+    if (!completed)
+    {
+        global_stats.local().symbol_timeouts++;
+        return;
+    }
+
+    global_stats.local().polls_per_symbol.record(polls);
+    if (polls > 4000) // >80% von 5000 Polls
+    {
+        global_stats.local().near_timeouts++;
+    }
+}
+
 // PROTOCOL LAYER
 
 bool B15Board::send_2bits(uint8_t data)
@@ -105,6 +171,7 @@ bool B15Board::send_2bits(uint8_t data)
     tx_clock_state ^= CLOCK;
     output |= tx_clock_state;
 
+    uint64_t start_ns = latency_now_ns();
     write_output(output); // TX schreibt DATA+CLOCK auf Bits 0-3
 
     for (int i = 0; i < 5000; i++)
@@ -115,17 +182,25 @@ bool B15Board::send_2bits(uint8_t data)
         if (received_ack != tx_last_received_ack)
         {
             tx_last_received_ack = received_ack;
+            uint64_t elapsed_ns = latency_now_ns() - start_ns;
+            global_stats.local().symbol_tx.record(elapsed_ns);
+            record_polls(i + 1, true);
+            B15_PROBE3(symbol_tx, output, i + 1, elapsed_ns);
             return true;
         }
 
-        drv.delay_us(100);
+        poll_sleep();
     }
 
+    record_polls(5000, false);
+    B15_PROBE2(timeout, 0, 5000);
     return false;
 }
 
 uint8_t B15Board::receive_2bits()
 {
+    uint64_t start_ns = latency_now_ns();
+
     for (int i = 0; i < 5000; i++)
     {
         uint8_t input = read_input(); // RX liest DATA+CLOCK vom anderen Board (via Bits 7-4)
@@ -145,13 +220,19 @@ uint8_t B15Board::receive_2bits()
             uint8_t output = rx_ack_state | rx_clock_state;
 
             write_output(output); // RX schreibt ACK auf Bits 0-3
+            uint64_t elapsed_ns = latency_now_ns() - start_ns;
+            global_stats.local().symbol_rx.record(elapsed_ns);
+            record_polls(i + 1, true);
+            B15_PROBE3(symbol_rx, data, i + 1, elapsed_ns);
 
             return data;
         }
 
-        drv.delay_us(100);
+        poll_sleep();
     }
 
+    record_polls(5000, false);
+    B15_PROBE2(timeout, 1, 5000);
     return 0xFF;
 }
 
@@ -168,46 +249,95 @@ bool B15Board::send_byte_raw(uint8_t byte)
     return true;
 }
 
-uint8_t B15Board::receive_byte_raw()
+// Timeout wird über den Rückgabewert gemeldet, nicht im Byte: alle 256
+// Werte sind gültig, z.B. die Checksum 0xFF von 0xB7. byte bleibt bei
+// einem Timeout unverändert. first_symbol_ns = Ankunft des 1. Symbols.
+bool B15Board::receive_byte_raw(uint8_t &byte, uint64_t *first_symbol_ns)
 {
-    uint8_t byte = 0;
+    uint8_t value = 0;
     uint8_t part;
 
     part = receive_2bits();
     if (part == 0xFF)
-        return 0xFF;
-    byte |= (part << 0);
+        return false;
+    value |= (part << 0);
+    if (first_symbol_ns)
+        *first_symbol_ns = latency_now_ns();
 
     part = receive_2bits();
     if (part == 0xFF)
-        return 0xFF;
-    byte |= (part << 2);
+        return false;
+    value |= (part << 2);
 
     part = receive_2bits();
     if (part == 0xFF)
-        return 0xFF;
-    byte |= (part << 4);
+        return false;
+    value |= (part << 4);
 
     part = receive_2bits();
     if (part == 0xFF)
-        return 0xFF;
-    byte |= (part << 6);
+        return false;
+    value |= (part << 6);
 
-    return byte;
+    byte = value;
+    return true;
 }
 
 // HIGH-LEVEL PROTOCOL
 
+// Steuerbytes getrennt von Nutzdaten ausweisen. channel_id merkt sich pro
+// Richtung, dass nach CHANNEL_BYTE noch die (ggf. maskierte) Kanalnummer
+// folgt, die ebenfalls zum Kanalwechsel zählt.
+static OverheadCategory overhead_category(uint8_t byte, bool &channel_id)
+{
+    if (byte == ABORT_BYTE)
+    {
+        channel_id = false;
+        return OVERHEAD_EOT;
+    }
+    if (channel_id)
+    {
+        channel_id = (byte == ESC_BYTE);
+        return OVERHEAD_CHANNEL;
+    }
+    if (byte == CHANNEL_BYTE)
+    {
+        channel_id = true;
+        return OVERHEAD_CHANNEL;
+    }
+    if (byte == EOT_BYTE)
+        return OVERHEAD_EOT;
+    if (byte == ESC_BYTE)
+        return OVERHEAD_ESCAPE;
+    if (byte == PROBE_BYTE)
+        return OVERHEAD_PROBE;
+    return OVERHEAD_PAYLOAD;
+}
+
+// ACK_BYTE ohne Verbraucher, sonst mit dem freien Platz im Empfangsfenster
+uint8_t B15Board::ack_byte()
+{
+    if (!rx_consumer || flow_settings.rx_window == 0)
+        return ACK_BYTE;
+
+    // Mindestens eine Einheit, sonst käme bei leerem Puffer nie Credit
+    size_t window = flow_settings.rx_window > CREDIT_UNIT ? flow_settings.rx_window : CREDIT_UNIT;
+    size_t backlog = rx_consumer->backlog();
+    return credit_ack(backlog < window ? window - backlog : 0);
+}
+
 bool B15Board::send_byte_with_checksum(uint8_t byte)
 {
     uint8_t checksum = calculate_checksum(byte);
+    uint64_t byte_start_ns = B15_PROBE_ENABLED(byte_tx) ? latency_now_ns() : 0;
 
     for (int retry = 0; retry < MAX_RETRIES; retry++)
     {
         if (retry > 0)
         {
             cout << "[" << name << "] WIEDERHOLUNG " << retry << "/" << MAX_RETRIES << endl;
-            global_stats.retransmissions++;
+            global_stats.local().retransmissions++;
+            B15_PROBE2(retry, byte, retry);
         }
 
         if (verbose)
@@ -217,27 +347,53 @@ bool B15Board::send_byte_with_checksum(uint8_t byte)
                  << hex << (int)checksum << dec << endl;
         }
 
+        uint64_t attempt_start_ns = latency_now_ns();
+
         if (!send_byte_raw(byte))
         {
             cerr << "[" << name << "] Fehler beim Senden!" << endl;
+            B15_PROBE4(byte_tx, byte, retry, latency_now_ns() - byte_start_ns, 0);
             return false;
         }
 
+        uint64_t checksum_start_ns = latency_now_ns();
+
         if (!send_byte_raw(checksum))
         {
             cerr << "[" << name << "] Fehler beim Senden der Checksum!" << endl;
+            B15_PROBE4(byte_tx, byte, retry, latency_now_ns() - byte_start_ns, 0);
             return false;
         }
 
-        uint8_t response = receive_byte_raw();
+        uint64_t response_start_ns = latency_now_ns();
+        uint8_t response = 0;
+        bool answered = receive_byte_raw(response);
+        uint64_t end_ns = latency_now_ns();
+        if (answered)
+        {
+            global_stats.local().byte_rtt.record(end_ns - attempt_start_ns);
+        }
+
+        if (!is_ack(response))
+        {
+            global_stats.add_overhead(OVERHEAD_RETRANSMIT, answered ? 12 : 8, end_ns - attempt_start_ns);
+        }
 
-        if (response == ACK_BYTE)
+        if (is_ack(response))
         {
+            tx_credit = ack_credit(response);
+            OverheadCategory category = overhead_category(byte, tx_channel_id);
+            global_stats.add_overhead(category, 4, checksum_start_ns - attempt_start_ns);
+            global_stats.add_overhead(OVERHEAD_CHECKSUM, 4, response_start_ns - checksum_start_ns);
+            global_stats.add_overhead(OVERHEAD_ACK, 4, end_ns - response_start_ns);
             if (verbose)
             {
                 cout << "[" << name << "] << ACK empfangen! Byte erfolgreich uebertragen." << endl;
             }
-            global_stats.bytes_sent++;
+            global_stats.local().bytes_sent++;
+            if (category == OVERHEAD_PAYLOAD)
+                global_stats.local().payload_sent++;
+            B15_PROBE4(byte_tx, byte, retry, end_ns - byte_start_ns, 1);
             return true;
         }
         else if (response == NACK_BYTE)
@@ -252,6 +408,7 @@ bool B15Board::send_byte_with_checksum(uint8_t byte)
     }
 
     cerr << "[" << name << "] XXX MAX RETRIES erreicht! Uebertragung fehlgeschlagen." << endl;
+    B15_PROBE4(byte_tx, byte, MAX_RETRIES, latency_now_ns() - byte_start_ns, 0);
     return false;
 }
 
@@ -262,8 +419,11 @@ uint8_t B15Board::receive_byte_with_checksum()
         cout << "\n[" << name << "] Warte auf Byte..." << endl;
     }
 
-    uint8_t byte = receive_byte_raw();
-    if (byte == 0xFF)
+    // Die Wartezeit auf das erste Symbol ist Leerlauf und zählt nicht zur
+    // Leitungsnutzung
+    uint64_t start_ns = 0;
+    uint8_t byte;
+    if (!receive_byte_raw(byte, &start_ns))
     {
         if (verbose)
         {
@@ -271,18 +431,21 @@ uint8_t B15Board::receive_byte_with_checksum()
         }
         return 0xFF;
     }
+    uint64_t checksum_start_ns = latency_now_ns();
 
     uint8_t received_byte = error_injector.inject_error(byte);
 
-    uint8_t received_checksum = receive_byte_raw();
-    if (received_checksum == 0xFF)
+    uint8_t received_checksum;
+    if (!receive_byte_raw(received_checksum))
     {
         if (verbose)
         {
             cerr << "[" << name << "] Timeout beim Empfangen der Checksum!" << endl;
         }
+        global_stats.add_overhead(OVERHEAD_RETRANSMIT, 4, latency_now_ns() - start_ns);
         return 0xFF;
     }
+    uint64_t response_start_ns = latency_now_ns();
 
     uint8_t expected_checksum = calculate_checksum(received_byte);
 
@@ -299,15 +462,26 @@ uint8_t B15Board::receive_byte_with_checksum()
         {
             cout << "[" << name << "] >> Checksum OK! Sende ACK." << endl;
         }
-        send_byte_raw(ACK_BYTE);
-        global_stats.bytes_received++;
+        send_byte_raw(ack_byte());
+        OverheadCategory category = overhead_category(received_byte, rx_channel_id);
+        global_stats.add_overhead(category, 4, checksum_start_ns - start_ns);
+        global_stats.add_overhead(OVERHEAD_CHECKSUM, 4, response_start_ns - checksum_start_ns);
+        uint64_t end_ns = latency_now_ns();
+        global_stats.add_overhead(OVERHEAD_ACK, 4, end_ns - response_start_ns);
+        global_stats.local().bytes_received++;
+        if (category == OVERHEAD_PAYLOAD)
+            global_stats.local().payload_received++;
+        B15_PROBE3(byte_rx, received_byte, 1, end_ns - start_ns);
         return received_byte;
     }
     else
     {
         cout << "[" << name << "] XX Checksum FEHLER! Sende NACK." << endl;
         send_byte_raw(NACK_BYTE);
-        global_stats.checksum_errors++;
+        uint64_t end_ns = latency_now_ns();
+        global_stats.add_overhead(OVERHEAD_RETRANSMIT, 12, end_ns - start_ns);
+        global_stats.local().checksum_errors++;
+        B15_PROBE3(byte_rx, received_byte, 0, end_ns - start_ns);
         return 0xFF;
     }
 }
@@ -320,49 +494,184 @@ void B15Board::run_sender_mode()
     cout << "[" << name << "] Gib Nachrichten ein (eine pro Zeile):" << endl;
     cout << "[" << name << "] Jede Zeile wird komplett gesendet + EOT" << endl;
 
-    string line;
-    while (getline(cin, line))
+    if (!send_input_stream(name))
+    {
+        cerr << "[" << name << "] Uebertragung abgebrochen!" << endl;
+    }
+    global_stats.print();
+}
+
+// Sendet ein Nutzdaten-Byte, maskiert falls nötig (siehe stuff_byte)
+bool B15Board::wait_for_credit()
+{
+    if (!credit_blocked())
     {
-        cout << "[" << name << "] Sende Nachricht: \"" << line << "\"" << endl;
+        return true;
+    }
 
-        for (char c : line)
+    if (verbose)
+    {
+        cout << "[" << name << "] Empfaenger hat keinen Platz, warte auf Credit" << endl;
+    }
+    uint64_t start_ns = latency_now_ns();
+    global_stats.local().credit_stalls++;
+    bool ok = true;
+    while (ok && credit_blocked())
+    {
+        drv.delay_ms(flow_settings.probe_interval_ms);
+        ok = send_byte_with_checksum(PROBE_BYTE);
+    }
+    global_stats.local().credit_wait_ns += latency_now_ns() - start_ns;
+    return ok;
+}
+
+// Bei vollem Empfangsfenster wird vorher gewartet, nie zwischen ESC und Byte
+bool B15Board::send_payload_byte(uint8_t byte)
+{
+    if (!wait_for_credit())
+        return false;
+
+    uint8_t wire[2];
+    int n = stuff_byte(byte, wire);
+    for (int i = 0; i < n; i++)
+    {
+        if (!send_byte_with_checksum(wire[i]))
+            return false;
+    }
+    return true;
+}
+
+// Streamt stdin: jedes Byte geht raus, sobald es gelesen ist, auch bei
+// Binärdaten. Nachrichtengrenze ist weiterhin '\n', der Rest nach dem
+// letzten '\n' wird bei EOF als eigene Nachricht abgeschlossen.
+bool B15Board::send_input_stream(const string &tag)
+{
+    InputStream input;
+    uint8_t block[4096];
+    size_t message_bytes = 0;
+    uint64_t message_start_ns = 0;
+    bool ok = true;
+
+    size_t n;
+    while (ok && running && (n = input.read(block, sizeof(block))) > 0)
+    {
+        for (size_t i = 0; i < n && ok; i++)
         {
-            if (!send_byte_with_checksum(c))
+            if (message_bytes == 0)
             {
-                cerr << "[" << name << "] Uebertragung abgebrochen!" << endl;
-                global_stats.print();
-                return;
+                message_start_ns = latency_now_ns();
             }
-        }
+            global_stats.tx_queue_bytes = input.buffered() + (n - i);
 
-        if (!send_byte_with_checksum('\n'))
-        {
-            cerr << "[" << name << "] Uebertragung abgebrochen!" << endl;
-            global_stats.print();
-            return;
-        }
+            ok = send_payload_byte(block[i]);
+            message_bytes++;
 
-        cout << "[" << name << "] Sende EOT (End of Transmission)" << endl;
-        if (!send_byte_with_checksum(EOT_BYTE))
-        {
-            cerr << "[" << name << "] Uebertragung abgebrochen!" << endl;
-            global_stats.print();
-            return;
+            if (ok && block[i] == '\n')
+            {
+                ok = finish_message(tag, message_bytes, message_start_ns);
+                message_bytes = 0;
+            }
         }
+    }
+
+    if (ok && message_bytes > 0)
+    {
+        ok = finish_message(tag, message_bytes, message_start_ns);
+    }
+    global_stats.tx_queue_bytes = 0;
+
+    if (!ok)
+    {
+        send_abort(tag);
+    }
+    return ok;
+}
 
-        cout << "[" << name << "] >>> Nachricht komplett gesendet! <<<\n"
-             << endl;
+// Nutzdaten am Stück, z.B. ein Ausschnitt einer eingeblendeten Datei.
+// Liest direkt aus data, es wird nichts kopiert.
+bool B15Board::send_block(const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        if (!send_payload_byte(data[i]))
+            return false;
+    }
+    return true;
+}
+
+void B15Board::run_send_file_mode(const string &path)
+{
+    MappedFile file;
+    string error;
+    if (!file.load(path, error))
+    {
+        cerr << "[" << name << "] " << error << endl;
+        return;
     }
 
+    cout << "\n[" << name << "] SEND-FILE MODE (Half-Duplex)" << endl;
+    cout << "[" << name << "] Sende " << path << " (" << file.size() << " Bytes) als eine Nachricht + EOT" << endl;
+
+    // Die Datei geht in Ausschnitten an send_block(); tx_queue_bytes zeigt
+    // den noch nicht gesendeten Rest
+    const size_t SLICE = 4096;
+    uint64_t message_start_ns = latency_now_ns();
+    bool ok = true;
+
+    for (size_t offset = 0; ok && offset < file.size(); offset += SLICE)
+    {
+        size_t len = min(SLICE, file.size() - offset);
+        global_stats.tx_queue_bytes = file.size() - offset;
+        ok = send_block(file.data() + offset, len);
+    }
+
+    if (ok)
+    {
+        ok = finish_message(name, file.size(), message_start_ns);
+    }
+    global_stats.tx_queue_bytes = 0;
+
+    if (!ok)
+    {
+        cerr << "[" << name << "] Uebertragung abgebrochen!" << endl;
+        send_abort(name);
+    }
     global_stats.print();
 }
 
+// Nach einem Fehler mitten in einer Nachricht, damit der Empfänger den
+// angefangenen Teil verwirft statt ihn beim nächsten EOT auszuliefern
+bool B15Board::send_abort(const string &tag)
+{
+    cerr << "[" << tag << "] Sende ABORT, Empfaenger verwirft angefangene Nachrichten" << endl;
+    return send_byte_with_checksum(ABORT_BYTE);
+}
+
+bool B15Board::finish_message(const string &tag, size_t message_bytes, uint64_t message_start_ns)
+{
+    if (verbose)
+    {
+        cout << "[" << tag << "] Sende EOT (End of Transmission)" << endl;
+    }
+    if (!send_byte_with_checksum(EOT_BYTE))
+    {
+        return false;
+    }
+
+    global_stats.message.record(latency_now_ns() - message_start_ns);
+    cout << "[" << tag << "] >>> Nachricht komplett gesendet (" << message_bytes << " Bytes) <<<" << endl;
+    return true;
+}
+
 void B15Board::run_receiver_mode()
 {
     cout << "\n[" << name << "] RECEIVER MODE (Half-Duplex)" << endl;
     cout << "[" << name << "] Warte auf Nachrichten (bis EOT)..." << endl;
 
-    string received_message = "";
+    ChannelArenas received(spill_settings, name); // Pro Kanal, zu große Nachrichten als Spill-Datei
+    uint64_t start_ns[MAX_CHANNELS] = {};
+    Unstuffer unstuffer;
+    ChannelTracker channels;
 
     while (true)
     {
@@ -373,26 +682,144 @@ void B15Board::run_receiver_mode()
             continue;
         }
 
-        if (byte == EOT_BYTE)
+        Unstuffer::Kind kind = unstuffer.feed(byte);
+        if (kind == Unstuffer::PENDING || !channels.feed(kind, byte))
+        {
+            continue;
+        }
+
+        if (kind == Unstuffer::CONTROL && byte == ABORT_BYTE)
+        {
+            cerr << "[" << name << "] ABORT empfangen, angefangene Nachrichten verworfen" << endl;
+            received.reset();
+            for (int i = 0; i < MAX_CHANNELS; i++)
+            {
+                start_ns[i] = 0;
+            }
+            continue;
+        }
+
+        // Nachrichten verschiedener Kanäle können sich abwechseln
+        int channel = channels.current();
+        MessageArena &received_message = received[channel];
+        uint64_t &message_start_ns = start_ns[channel];
+        if (message_start_ns == 0)
+        {
+            message_start_ns = latency_now_ns();
+        }
+
+        if (kind == Unstuffer::CONTROL && byte == EOT_BYTE)
         {
             cout << "[" << name << "] EOT empfangen! Nachricht komplett." << endl;
+            uint64_t message_size = received_message.size();
+            string note;
             cout << "[" << name << "] EMPFANGENE NACHRICHT:" << endl;
-            cout << ">>> " << received_message << " <<<" << endl;
+            cout << ">>> " << received_message.take_message(note) << " <<<" << endl;
             cout << endl;
+            uint64_t message_ns = latency_now_ns() - message_start_ns;
+            global_stats.message.record(message_ns);
+            B15_PROBE2(message_rx, message_size, message_ns);
 
-            received_message = "";
+            received_message.reset();
+            message_start_ns = 0;
             continue;
         }
 
-        received_message += (char)byte;
+        received_message.push(byte);
         if (verbose)
         {
             cout << "[" << name << "] Zeichen empfangen: '" << (char)byte
-                 << "' (Message bisher: \"" << received_message << "\")" << endl;
+                 << "' (Message bisher: " << received_message.size() << " Bytes)" << endl;
         }
     }
 }
 
+// Wie run_receiver_mode, aber ohne Nachrichtenpuffer: Nutzdaten gehen in
+// Stücken von höchstens FRAME_BYTES in den Ausgabepuffer, spätestens bei
+// EOT, ABORT oder ruhiger Leitung; EOT leert ihn. cout muss dafür auf
+// stderr umgeleitet sein (siehe main.cpp).
+void B15Board::run_raw_receiver_mode()
+{
+    cout << "\n[" << name << "] RECEIVER MODE (roh, Nutzdaten auf stdout)" << endl;
+
+    RawOutput out;
+    rx_consumer = &out; // Credits nach dem Rückstand der Ausgabe
+    uint64_t message_start_ns = 0;
+    uint64_t message_bytes = 0;
+    Unstuffer unstuffer;
+    ChannelTracker channels; // Kanalwechsel werden übergangen, die Kanäle nicht getrennt
+    uint8_t pending[FRAME_BYTES];
+    size_t pending_len = 0;
+    auto push_pending = [&]()
+    {
+        if (pending_len > 0)
+        {
+            out.write(pending, pending_len);
+            pending_len = 0;
+        }
+    };
+
+    while (out.ok())
+    {
+        uint8_t byte = receive_byte_with_checksum();
+
+        if (byte == 0xFF)
+        {
+            push_pending(); // Nichts kommt nach, Gesammeltes nicht liegen lassen
+            continue;
+        }
+
+        Unstuffer::Kind kind = unstuffer.feed(byte);
+        if (kind == Unstuffer::PENDING || !channels.feed(kind, byte))
+        {
+            continue;
+        }
+
+        if (kind == Unstuffer::CONTROL && byte == ABORT_BYTE)
+        {
+            // Schon ausgegebene Bytes lassen sich nicht zurückholen
+            push_pending();
+            cerr << "[" << name << "] ABORT empfangen, Nachricht nach " << message_bytes
+                 << " ausgegebenen Bytes abgebrochen" << endl;
+            message_start_ns = 0;
+            message_bytes = 0;
+            continue;
+        }
+
+        if (message_start_ns == 0)
+        {
+            message_start_ns = latency_now_ns();
+        }
+
+        if (kind == Unstuffer::CONTROL && byte == EOT_BYTE)
+        {
+            push_pending();
+            out.flush();
+            uint64_t message_ns = latency_now_ns() - message_start_ns;
+            global_stats.message.record(message_ns);
+            B15_PROBE2(message_rx, message_bytes, message_ns);
+            if (verbose)
+            {
+                cout << "[" << name << "] EOT, " << message_bytes << " Bytes ausgegeben" << endl;
+            }
+
+            message_start_ns = 0;
+            message_bytes = 0;
+            continue;
+        }
+
+        pending[pending_len++] = byte;
+        message_bytes++;
+        if (pending_len == sizeof(pending))
+        {
+            push_pending();
+        }
+    }
+
+    rx_consumer = nullptr;
+    cerr << "[" << name << "] stdout geschlossen, Empfang beendet" << endl;
+}
+
 // FULL-DUPLEX THREADS
 
 void B15Board::sender_thread()
@@ -400,42 +827,108 @@ void B15Board::sender_thread()
     cout << "\n[" << name << " TX] SENDER-THREAD gestartet" << endl;
     cout << "[" << name << " TX] Gib Nachrichten ein:" << endl;
 
-    string line;
-    while (running && getline(cin, line))
+    if (!send_input_stream(name + " TX"))
     {
-        cout << "[" << name << " TX] >>> Sende: \"" << line << "\"" << endl;
+        cerr << "[" << name << " TX] Fehler!" << endl;
+    }
+}
 
-        for (char c : line)
+// Daemon-Modus: Nachrichten der Clients statt stdin, jede mit Bestätigung
+void B15Board::daemon_sender_thread(LinkDaemon &daemon)
+{
+    string tag = name + " TX";
+    OutgoingFrame frame;
+    int tx_channel = 0; // Stand des Empfängers, -1 = unbekannt
+    uint64_t start_ns[MAX_CHANNELS] = {};
+    size_t message_bytes[MAX_CHANNELS] = {};
+    bool abort_pending = false; // ABORT_BYTE muss vor dem nächsten Frame raus
+
+    while (running && daemon.running())
+    {
+        if (!daemon.next_frame(frame, 100))
+        {
+            continue;
+        }
+        global_stats.tx_queue_bytes = daemon.queued_bytes() + frame.data.size();
+        if (frame.first)
+        {
+            start_ns[frame.channel] = latency_now_ns();
+            message_bytes[frame.channel] = 0;
+        }
+
+        // Kanal nur bei Wechsel umschalten
+        bool ok = true;
+        if (abort_pending)
+        {
+            abort_pending = !send_abort(tag);
+            ok = !abort_pending;
+        }
+        if (ok && frame.channel != tx_channel)
         {
-            if (!send_byte_with_checksum(c))
+            uint8_t wire[3];
+            int wire_bytes = channel_switch(frame.channel, wire);
+            for (int i = 0; i < wire_bytes && ok; i++)
             {
-                cerr << "[" << name << " TX] Fehler!" << endl;
-                return;
+                ok = send_byte_with_checksum(wire[i]);
             }
+            tx_channel = frame.channel;
         }
+        ok = ok && send_block(frame.data.data(), frame.data.size());
+        message_bytes[frame.channel] += frame.data.size();
 
-        send_byte_with_checksum('\n');
-        send_byte_with_checksum(EOT_BYTE);
+        if (ok && frame.last)
+        {
+            ok = finish_message(tag, message_bytes[frame.channel], start_ns[frame.channel]);
+        }
 
-        cout << "[" << name << " TX] Nachricht gesendet!\n"
-             << endl;
+        // Nach einem Fehler ABORT statt EOT: der Empfänger verwirft alle
+        // Teilnachrichten, hier scheitern deshalb auch die angefangenen
+        // Nachrichten der anderen Kanäle. Danach steht er auf Kanal 0.
+        if (!ok)
+        {
+            cerr << "[" << tag << "] Uebertragung fehlgeschlagen!" << endl;
+            if (!abort_pending)
+            {
+                abort_pending = !send_abort(tag);
+            }
+            tx_channel = abort_pending ? -1 : 0;
+        }
+        daemon.sent(frame, ok);
+        if (!ok)
+        {
+            daemon.abort_started();
+        }
+        global_stats.tx_queue_bytes = daemon.queued_bytes();
     }
 }
 
-void B15Board::receiver_thread()
+void B15Board::receiver_thread(LinkDaemon *daemon)
 {
     cout << "[" << name << " RX] RECEIVER-THREAD gestartet" << endl;
 
     string filename = "received_" + name + ".txt";
-    ofstream outfile(filename, ios::app);
+    GroupCommitWriter outfile(writer_settings);
+    string error;
 
-    if (outfile.is_open())
+    if (daemon)
+    {
+        cout << "[" << name << " RX] Empfangene Nachrichten gehen an die Abonnenten" << endl;
+    }
+    else if (!outfile.open(filename, error))
+    {
+        cerr << "[" << name << " RX] " << error << endl;
+    }
+    else
     {
         cout << "[" << name << " RX] Schreibe empfangene Nachrichten in: "
              << filename << endl;
+        rx_consumer = &outfile; // Credits nach dem Rückstand des Writers
     }
 
-    string received_message = "";
+    ChannelArenas received(spill_settings, name); // Pro Kanal, zu große Nachrichten als Spill-Datei
+    uint64_t start_ns[MAX_CHANNELS] = {};
+    Unstuffer unstuffer;
+    ChannelTracker channels;
 
     while (running)
     {
@@ -447,27 +940,58 @@ void B15Board::receiver_thread()
             continue;
         }
 
-        if (byte == EOT_BYTE)
+        Unstuffer::Kind kind = unstuffer.feed(byte);
+        if (kind == Unstuffer::PENDING || !channels.feed(kind, byte))
         {
-            cout << "[" << name << " RX] EMPFANGEN: \"" << received_message << "\"" << endl;
+            continue;
+        }
+
+        if (kind == Unstuffer::CONTROL && byte == ABORT_BYTE)
+        {
+            cerr << "[" << name << " RX] ABORT empfangen, angefangene Nachrichten verworfen" << endl;
+            received.reset();
+            for (int i = 0; i < MAX_CHANNELS; i++)
+            {
+                start_ns[i] = 0;
+            }
+            continue;
+        }
 
-            if (outfile.is_open())
+        // Nachrichten verschiedener Kanäle können sich abwechseln
+        int channel = channels.current();
+        MessageArena &received_message = received[channel];
+        uint64_t &message_start_ns = start_ns[channel];
+        if (message_start_ns == 0)
+        {
+            message_start_ns = latency_now_ns();
+        }
+
+        if (kind == Unstuffer::CONTROL && byte == EOT_BYTE)
+        {
+            // Zu große Nachrichten liegen in einer Spill-Datei, dann nur der Verweis
+            string note;
+            ByteSpan message = received_message.take_message(note);
+            cout << "[" << name << " RX] EMPFANGEN: \"" << message << "\"" << endl;
+
+            if (daemon)
+            {
+                daemon->deliver(channel, message);
+            }
+            else if (outfile.is_open())
             {
-                outfile << received_message << endl;
-                outfile.flush();
+                outfile.append(message);
             }
 
-            received_message = "";
+            global_stats.message.record(latency_now_ns() - message_start_ns);
+            received_message.reset();
+            message_start_ns = 0;
             continue;
         }
 
-        received_message += (char)byte;
+        received_message.push(byte);
     }
 
-    if (outfile.is_open())
-    {
-        outfile.close();
-    }
+    rx_consumer = nullptr;
 }
 
 void B15Board::run_fullduplex_mode()
@@ -490,3 +1014,24 @@ void B15Board::run_fullduplex_mode()
     cout << "\n[" << name << "] Full-Duplex Mode beendet." << endl;
     global_stats.print();
 }
+
+void B15Board::run_daemon_mode(LinkDaemon &daemon)
+{
+    cout << "\n[" << name << "]  DAEMON MODE" << endl;
+    cout << "[" << name << "] Link bleibt warm, Clients ueber den Socket" << endl;
+    cout << "[" << name << "] HINWEIS: Mutex-Locks schuetzen B15F-Zugriffe!\n"
+         << endl;
+
+    // Wie Full-Duplex, nur mit den Clients als Quelle und Ziel
+    thread sender([this, &daemon]()
+                  { this->daemon_sender_thread(daemon); });
+    thread receiver([this, &daemon]()
+                    { this->receiver_thread(&daemon); });
+
+    sender.join();
+    running = false;
+    receiver.join();
+
+    cout << "\n[" << name << "] Daemon beendet." << endl;
+    global_stats.print();
+}
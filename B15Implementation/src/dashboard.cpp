@@ -0,0 +1,138 @@
+#include "../include/dashboard.h"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+using namespace std;
+
+// Gewicht des neuesten Messintervalls in der geglätteten Rate
+static const double SMOOTHING = 0.3;
+
+static double smooth(double old_rate, double new_rate)
+{
+    return old_rate < 0 ? new_rate : old_rate + SMOOTHING * (new_rate - old_rate);
+}
+
+static string format_eta(double seconds)
+{
+    if (seconds < 0 || seconds > 99 * 3600)
+        return "--:--";
+
+    char buf[32];
+    unsigned s = (unsigned)(seconds + 0.5);
+    if (s >= 3600)
+        snprintf(buf, sizeof(buf), "%u:%02u:%02u", s / 3600, s / 60 % 60, s % 60);
+    else
+        snprintf(buf, sizeof(buf), "%02u:%02u", s / 60, s % 60);
+    return buf;
+}
+
+Dashboard::Dashboard(const Stats &s, const string &board)
+    : stats(s), board_name(board), total_bytes(0), stopping(false), interval_ms(0),
+      payload_rate(-1), tx_payload_rate(-1), symbol_rate(-1), retx_rate(-1)
+{
+    last_ns = latency_now_ns();
+    last = stats.snapshot();
+    last_symbols = stats.count(&StatsShard::symbol_tx) + stats.count(&StatsShard::symbol_rx);
+}
+
+Dashboard::~Dashboard()
+{
+    stop();
+}
+
+void Dashboard::set_total_bytes(uint64_t total)
+{
+    lock_guard<mutex> lock(mtx);
+    total_bytes = total;
+}
+
+void Dashboard::start(int interval)
+{
+    if (worker.joinable() || interval <= 0)
+        return;
+
+    interval_ms = interval;
+    stopping = false;
+    worker = thread(&Dashboard::run, this);
+}
+
+void Dashboard::stop()
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        stopping = true;
+    }
+    wakeup.notify_all();
+
+    if (worker.joinable())
+    {
+        worker.join();
+
+        // Endstand anzeigen und die Zeile stehen lassen
+        lock_guard<mutex> lock(mtx);
+        refresh();
+        cerr << endl;
+    }
+}
+
+void Dashboard::run()
+{
+    unique_lock<mutex> lock(mtx);
+    while (!stopping)
+    {
+        wakeup.wait_for(lock, chrono::milliseconds(interval_ms));
+        if (stopping)
+            break;
+
+        refresh();
+    }
+}
+
+// Läuft mit gehaltenem mtx, der nur Dashboard-intern ist
+void Dashboard::refresh()
+{
+    uint64_t now_ns = latency_now_ns();
+    StatsSnapshot cur = stats.snapshot();
+    uint64_t symbols = stats.count(&StatsShard::symbol_tx) + stats.count(&StatsShard::symbol_rx);
+    uint64_t queued = stats.tx_queue_bytes.load(memory_order_relaxed);
+
+    double dt = (now_ns - last_ns) / 1e9;
+    if (dt <= 0)
+        return;
+
+    // Nur Nutzdaten, bytes_sent enthält auch ESC-, Kanal- und Probe-Bytes
+    uint64_t tx_payload = cur.payload_sent - last.payload_sent;
+    uint64_t payload = tx_payload + (cur.payload_received - last.payload_received);
+    payload_rate = smooth(payload_rate, payload / dt);
+    tx_payload_rate = smooth(tx_payload_rate, tx_payload / dt);
+    symbol_rate = smooth(symbol_rate, (symbols - last_symbols) / dt);
+    retx_rate = smooth(retx_rate, (cur.retransmissions - last.retransmissions) / dt);
+
+    last_ns = now_ns;
+    last = cur;
+    last_symbols = symbols;
+
+    // Anteile kumuliert, pro Intervall wären es bei wenigen Bytes nur Ausreißer
+    uint64_t attempts = cur.bytes_sent + cur.retransmissions;
+    uint64_t checked = cur.bytes_received + cur.checksum_errors;
+    double retx_share = attempts > 0 ? cur.retransmissions * 100.0 / attempts : 0.0;
+    double error_share = checked > 0 ? cur.checksum_errors * 100.0 / checked : 0.0;
+
+    char line[200];
+    int len = snprintf(line, sizeof(line),
+                       "[%s] %.1f B/s | %.0f Sym/s | Retx %.1f/s (%.1f%%) | Fehler %.1f%% | Queue %llu B",
+                       board_name.c_str(), payload_rate, symbol_rate, retx_rate, retx_share,
+                       error_share, (unsigned long long)queued);
+
+    if (total_bytes > 0 && len > 0 && len < (int)sizeof(line))
+    {
+        uint64_t done = cur.payload_sent < total_bytes ? cur.payload_sent : total_bytes;
+        double eta = tx_payload_rate > 0 ? (total_bytes - done) / tx_payload_rate : -1;
+        snprintf(line + len, sizeof(line) - len, " | %.0f%% | ETA %s",
+                 done * 100.0 / total_bytes, format_eta(eta).c_str());
+    }
+
+    // \033[K löscht den Rest einer vorher längeren Zeile
+    cerr << '\r' << line << "\033[K" << flush;
+}
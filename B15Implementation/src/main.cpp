@@ -1,8 +1,13 @@
 #include "../include/b15board.h"
 #include "../include/protocol.h"
 #include "../include/stats.h"
+#include "../include/stats_export.h"
+#include "../include/dashboard.h"
 #include <iostream>
+#include <csignal>
 #include <cstdlib>
+#include <memory>
+#include <sys/stat.h>
 
 using namespace std;
 
@@ -10,16 +15,42 @@ int main(int argc, char *argv[])
 {
     if (argc < 3)
     {
-        cout << "Usage: " << argv[0] << " <board> <mode> [verbose]" << endl;
+        cout << "Usage: " << argv[0] << " <board> <mode> [verbose] [--stats-out=<prefix>] [--stats-interval=<s>]" << endl;
+        cout << "       [--dashboard[=<ms>]] [--file=<pfad>] [--fsync=<policy>]" << endl;
+        cout << "       [--max-message=<bytes>] [--spill-dir=<dir>] [--raw] [--socket=<pfad>]" << endl;
+        cout << "       [--channel=<n>] [--rx-window=<bytes>]" << endl;
         cout << "  board:   A oder B (Board-Kennung)" << endl;
-        cout << "  mode:    send, receive, oder fullduplex" << endl;
+        cout << "  mode:    send, send-file, receive, fullduplex, daemon, submit oder subscribe" << endl;
+        cout << "           daemon: haelt den Link warm, Clients ueber einen Unix-Socket" << endl;
+        cout << "           submit: stdin zeilenweise an den Daemon, subscribe: Empfang vom Daemon" << endl;
         cout << "  verbose: 0 oder 1 (optional, default: 0)" << endl;
+        cout << "  --stats-out:      Schreibt <prefix>.json, .csv und .prom periodisch" << endl;
+        cout << "  --stats-interval: Export-Intervall in Sekunden (default: 5)" << endl;
+        cout << "  --dashboard:      Live-Statuszeile auf stderr, Refresh in ms (default: 250)" << endl;
+        cout << "  --file:           Quelldatei fuer send-file (wird per mmap gelesen, auch binaer)" << endl;
+        cout << "  --fsync:          received_X.txt sichern: none (default), periodic (1 s), batch" << endl;
+        cout << "  --max-message:    Groessere Nachrichten in eine Spill-Datei auslagern" << endl;
+        cout << "                    (default: 64M, Suffix K/M/G, 0 = unbegrenzt im Speicher)" << endl;
+        cout << "  --spill-dir:      Verzeichnis der Spill-Dateien (default: .)" << endl;
+        cout << "  --rx-window:      Rueckstand von received_X.txt bzw. --raw, ab dem der Sender" << endl;
+        cout << "                    per Credit pausiert (default: 0 = aus)" << endl;
+        cout << "  --socket:         Socket fuer daemon/submit/subscribe (default: b15link_<board>.sock)" << endl;
+        cout << "  --channel:        Nur mit submit: virtueller Kanal 0-7, 0 = hoechste Prioritaet (default: 0)" << endl;
+        cout << "  --raw:            Nur mit receive: Nutzdaten unveraendert auf stdout, Meldungen auf stderr" << endl;
         cout << "\nBeispiel (Half-Duplex):" << endl;
         cout << "  Board A: " << argv[0] << " A send" << endl;
         cout << "  Board B: " << argv[0] << " B receive" << endl;
         cout << "\nBeispiel (Full-Duplex):" << endl;
         cout << "  Board A: " << argv[0] << " A fullduplex" << endl;
         cout << "  Board B: " << argv[0] << " B fullduplex" << endl;
+        cout << "\nBeispiel (Pipeline):" << endl;
+        cout << "  Board A: tar c daten | " << argv[0] << " A send" << endl;
+        cout << "  Board B: " << argv[0] << " B receive --raw | tar x" << endl;
+        cout << "\nBeispiel (Daemon):" << endl;
+        cout << "  Board A: " << argv[0] << " A daemon" << endl;
+        cout << "  Board B: " << argv[0] << " B daemon" << endl;
+        cout << "  Clients: echo hallo | " << argv[0] << " A submit   bzw.   " << argv[0] << " B subscribe" << endl;
+        cout << "           " << argv[0] << " A submit --channel=7 < gross.txt   (wird von Kanal 0 ueberholt)" << endl;
         cout << "\nBeispiel (mit Verbose):" << endl;
         cout << "  Board A: " << argv[0] << " A send 1" << endl;
         return 1;
@@ -28,10 +59,102 @@ int main(int argc, char *argv[])
     string board_id = argv[1];
     string mode = argv[2];
     bool verbose = false;
+    string stats_prefix;
+    double stats_interval_s = 5;
+    int dashboard_ms = 0;
+    string file_path;
+    WriterSettings writer_settings;
+    SpillSettings spill_settings;
+    FlowSettings flow_settings;
+    bool raw = false;
+    string socket_path;
+    int channel = 0;
 
-    if (argc >= 4)
+    for (int i = 3; i < argc; i++)
     {
-        verbose = (atoi(argv[3]) == 1);
+        string arg = argv[i];
+
+        if (arg.compare(0, 12, "--stats-out=") == 0)
+        {
+            stats_prefix = arg.substr(12);
+        }
+        else if (arg.compare(0, 17, "--stats-interval=") == 0)
+        {
+            stats_interval_s = atof(arg.c_str() + 17);
+            if (stats_interval_s <= 0)
+            {
+                cerr << "Export-Intervall muss groesser als 0 sein!" << endl;
+                return 1;
+            }
+        }
+        else if (arg == "--dashboard" || arg.compare(0, 12, "--dashboard=") == 0)
+        {
+            dashboard_ms = arg.size() > 12 ? atoi(arg.c_str() + 12) : 250;
+            if (dashboard_ms <= 0)
+            {
+                cerr << "Dashboard-Intervall muss groesser als 0 sein!" << endl;
+                return 1;
+            }
+        }
+        else if (arg.compare(0, 8, "--fsync=") == 0)
+        {
+            if (!parse_fsync_policy(arg.substr(8), writer_settings.fsync_policy))
+            {
+                cerr << "Unbekannte fsync-Policy: " << arg.substr(8) << endl;
+                return 1;
+            }
+        }
+        else if (arg.compare(0, 9, "--socket=") == 0)
+        {
+            socket_path = arg.substr(9);
+        }
+        else if (arg.compare(0, 10, "--channel=") == 0)
+        {
+            channel = atoi(arg.c_str() + 10);
+            if (channel < 0 || channel >= MAX_CHANNELS)
+            {
+                cerr << "Kanal muss zwischen 0 und " << MAX_CHANNELS - 1 << " sein!" << endl;
+                return 1;
+            }
+        }
+        else if (arg == "--raw")
+        {
+            raw = true;
+        }
+        else if (arg.compare(0, 14, "--max-message=") == 0)
+        {
+            if (!parse_byte_size(arg.substr(14), spill_settings.memory_limit))
+            {
+                cerr << "Ungueltige Groesse: " << arg.substr(14) << endl;
+                return 1;
+            }
+        }
+        else if (arg.compare(0, 12, "--rx-window=") == 0)
+        {
+            if (!parse_byte_size(arg.substr(12), flow_settings.rx_window))
+            {
+                cerr << "Ungueltige Groesse: " << arg.substr(12) << endl;
+                return 1;
+            }
+        }
+        else if (arg.compare(0, 12, "--spill-dir=") == 0)
+        {
+            spill_settings.directory = arg.substr(12);
+        }
+        else if (arg.compare(0, 7, "--file=") == 0)
+        {
+            file_path = arg.substr(7);
+        }
+        else if (arg == "0" || arg == "1")
+        {
+            verbose = (arg == "1");
+        }
+        else
+        {
+            // Tippfehler in Optionen nicht still übergehen
+            cerr << "Unbekannte Option: " << arg << " (ohne Argumente aufrufen fuer die Hilfe)" << endl;
+            return 1;
+        }
     }
 
     // Validiere Board-Kennung
@@ -41,6 +164,43 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    if (mode == "send-file" && file_path.empty())
+    {
+        cerr << "send-file braucht --file=<pfad>!" << endl;
+        return 1;
+    }
+
+    if (raw && mode != "receive")
+    {
+        cerr << "--raw gibt es nur fuer receive!" << endl;
+        return 1;
+    }
+
+    if (socket_path.empty())
+    {
+        socket_path = default_daemon_socket(board_id);
+    }
+
+    // Clients brauchen kein eigenes Board, der Daemon hält den Link
+    if (mode == "submit")
+    {
+        return run_daemon_submit(socket_path, channel);
+    }
+    if (mode == "subscribe")
+    {
+        return run_daemon_subscribe(socket_path);
+    }
+
+    if (raw)
+    {
+        // stdout gehört ab hier allein den Nutzdaten, alle Meldungen auf stderr
+        cout.rdbuf(cerr.rdbuf());
+#ifndef _WIN32
+        // Geschlossene Pipe (z.B. "| head") als Schreibfehler melden statt abzubrechen
+        signal(SIGPIPE, SIG_IGN);
+#endif
+    }
+
     cout << "B15F Full-Duplex Kommunikation" << endl;
     cout << "Mit Checksumme & ARQ" << endl;
     cout << endl;
@@ -53,12 +213,64 @@ int main(int argc, char *argv[])
     }
     cout << endl;
 
+    // Socket vor dem Board: ein zweiter Daemon darf das Board nicht anfassen
+    unique_ptr<LinkDaemon> daemon;
+    if (mode == "daemon")
+    {
+        daemon.reset(new LinkDaemon(socket_path));
+        string error;
+        if (!daemon->start(error))
+        {
+            cerr << error << endl;
+            return 1;
+        }
+        cout << "Daemon-Socket: " << socket_path << endl;
+    }
+
     B15Board board(board_id, verbose);
+    board.set_writer_settings(writer_settings);
+    board.set_spill_settings(spill_settings);
+    board.set_flow_settings(flow_settings);
+
+    // Empfänger laufen endlos, daher periodisch statt nur am Ende exportieren
+    unique_ptr<StatsExporter> exporter;
+    if (!stats_prefix.empty())
+    {
+        exporter.reset(new StatsExporter(global_stats, stats_prefix, board_id));
+        exporter->start((int)(stats_interval_s * 1000));
+        cout << "Statistik-Export: " << stats_prefix << ".{json,csv,prom}" << endl;
+    }
+
+    unique_ptr<Dashboard> dashboard;
+    if (dashboard_ms > 0)
+    {
+        dashboard.reset(new Dashboard(global_stats, board_id));
+
+        // Bei umgeleiteter Eingabedatei ist die Gesamtgröße bekannt -> ETA
+        struct stat st;
+        if (mode == "send-file" && stat(file_path.c_str(), &st) == 0)
+        {
+            dashboard->set_total_bytes((uint64_t)st.st_size);
+        }
+        else if (mode != "receive" && fstat(0, &st) == 0 && S_ISREG(st.st_mode))
+        {
+            dashboard->set_total_bytes((uint64_t)st.st_size);
+        }
+        dashboard->start(dashboard_ms);
+    }
 
     if (mode == "send")
     {
         board.run_sender_mode();
     }
+    else if (mode == "send-file")
+    {
+        board.run_send_file_mode(file_path);
+    }
+    else if (mode == "receive" && raw)
+    {
+        board.run_raw_receiver_mode();
+    }
     else if (mode == "receive")
     {
         board.run_receiver_mode();
@@ -67,9 +279,13 @@ int main(int argc, char *argv[])
     {
         board.run_fullduplex_mode();
     }
+    else if (mode == "daemon")
+    {
+        board.run_daemon_mode(*daemon);
+    }
     else
     {
-        cerr << "Mode muss 'send', 'receive' oder 'fullduplex' sein!" << endl;
+        cerr << "Mode muss 'send', 'send-file', 'receive', 'fullduplex', 'daemon', 'submit' oder 'subscribe' sein!" << endl;
         return 1;
     }
 
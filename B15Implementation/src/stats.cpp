@@ -1,19 +1,210 @@
 #include "../include/stats.h"
+#include <atomic>
+#include <iomanip>
 #include <iostream>
 
 using namespace std;
 
 Stats global_stats;
 
+static atomic<int> next_shard(0);
+
+static const char *const OVERHEAD_NAMES[OVERHEAD_CATEGORIES][2] = {
+    {"payload", "Nutzdaten"},
+    {"checksum", "Checksum"},
+    {"ack", "ACK/NACK"},
+    {"eot", "EOT"},
+    {"no_data", "NO_DATA"},
+    {"escape", "ESC"},
+    {"channel", "CH"},
+    {"probe", "Probe"},
+    {"retransmit", "Wiederholungen"},
+};
+
+const char *overhead_key(int category)
+{
+    return OVERHEAD_NAMES[category][0];
+}
+
+const char *overhead_label(int category)
+{
+    return OVERHEAD_NAMES[category][1];
+}
+
+StatsShard &Stats::local()
+{
+    // Jeder Thread bekommt beim ersten Zugriff einen festen Shard. Bei mehr
+    // Threads als Shards teilen sich einige einen, die Atomics bleiben korrekt.
+    static thread_local int index = next_shard.fetch_add(1) % MAX_SHARDS;
+    return shards[index];
+}
+
+void Stats::add_overhead(OverheadCategory category, uint64_t symbols, uint64_t ns)
+{
+    StatsShard &shard = local();
+    shard.overhead_symbols[category].fetch_add(symbols, memory_order_relaxed);
+    shard.overhead_ns[category].fetch_add(ns, memory_order_relaxed);
+}
+
+StatsSnapshot Stats::snapshot() const
+{
+    StatsSnapshot s = {};
+    for (int i = 0; i < MAX_SHARDS; i++)
+    {
+        const StatsShard &shard = shards[i];
+        s.bytes_sent += shard.bytes_sent.load(memory_order_relaxed);
+        s.bytes_received += shard.bytes_received.load(memory_order_relaxed);
+        s.payload_sent += shard.payload_sent.load(memory_order_relaxed);
+        s.payload_received += shard.payload_received.load(memory_order_relaxed);
+        s.retransmissions += shard.retransmissions.load(memory_order_relaxed);
+        s.checksum_errors += shard.checksum_errors.load(memory_order_relaxed);
+        s.credit_stalls += shard.credit_stalls.load(memory_order_relaxed);
+        s.credit_wait_ns += shard.credit_wait_ns.load(memory_order_relaxed);
+        s.poll_iterations += shard.poll_iterations.load(memory_order_relaxed);
+        s.io_time_ns += shard.io_time_ns.load(memory_order_relaxed);
+        s.sleep_time_ns += shard.sleep_time_ns.load(memory_order_relaxed);
+        s.sleep_requested_ns += shard.sleep_requested_ns.load(memory_order_relaxed);
+        s.near_timeouts += shard.near_timeouts.load(memory_order_relaxed);
+        s.symbol_timeouts += shard.symbol_timeouts.load(memory_order_relaxed);
+        s.write_errors += shard.write_errors.load(memory_order_relaxed);
+        for (int c = 0; c < OVERHEAD_CATEGORIES; c++)
+        {
+            s.overhead_symbols[c] += shard.overhead_symbols[c].load(memory_order_relaxed);
+            s.overhead_ns[c] += shard.overhead_ns[c].load(memory_order_relaxed);
+        }
+    }
+    return s;
+}
+
+void Stats::merged(LatencyHistogram StatsShard::*which, LatencyHistogram &out) const
+{
+    out.reset();
+    for (int i = 0; i < MAX_SHARDS; i++)
+    {
+        out.merge(shards[i].*which);
+    }
+}
+
+uint64_t Stats::count(LatencyHistogram StatsShard::*which) const
+{
+    uint64_t n = 0;
+    for (int i = 0; i < MAX_SHARDS; i++)
+    {
+        n += (shards[i].*which).count();
+    }
+    return n;
+}
+
+// Aufschlüsselung aus OverheadCategory, nur wenn etwas gezählt wurde
+static void print_overhead(const StatsSnapshot &s)
+{
+    uint64_t total_symbols = 0, total_ns = 0;
+    for (int c = 0; c < OVERHEAD_CATEGORIES; c++)
+    {
+        total_symbols += s.overhead_symbols[c];
+        total_ns += s.overhead_ns[c];
+    }
+    if (total_symbols == 0)
+        return;
+
+    cout << "Leitungsnutzung (Symbole / Zeit):" << endl;
+    ios::fmtflags flags = cout.flags();
+    streamsize precision = cout.precision();
+    cout << fixed << setprecision(1);
+    for (int c = 0; c < OVERHEAD_CATEGORIES; c++)
+    {
+        if (s.overhead_symbols[c] == 0)
+            continue;
+
+        cout << "  " << left << setw(16) << overhead_label(c) << right
+             << setw(10) << s.overhead_symbols[c] << " Sym " << setw(5)
+             << s.overhead_symbols[c] * 100.0 / total_symbols << "%  "
+             << setw(10) << s.overhead_ns[c] / 1e6 << " ms " << setw(5)
+             << (total_ns > 0 ? s.overhead_ns[c] * 100.0 / total_ns : 0.0) << "%" << endl;
+    }
+
+    // Alles außer den Nutzdaten ist Overhead
+    uint64_t overhead_symbols = total_symbols - s.overhead_symbols[OVERHEAD_PAYLOAD];
+    uint64_t overhead_ns = total_ns - s.overhead_ns[OVERHEAD_PAYLOAD];
+    cout << "  Overhead:        " << overhead_symbols * 100.0 / total_symbols << "% der Symbole, "
+         << (total_ns > 0 ? overhead_ns * 100.0 / total_ns : 0.0) << "% der Zeit" << endl;
+    cout.flags(flags);
+    cout.precision(precision);
+}
+
 void Stats::print()
 {
-    cout << "Bytes gesendet:     " << bytes_sent.load() << endl;
-    cout << "Bytes empfangen:    " << bytes_received.load() << endl;
-    cout << "Wiederholungen:     " << retransmissions.load() << endl;
-    cout << "Checksum-Fehler:    " << checksum_errors.load() << endl;
-    if (bytes_sent.load() > 0)
+    StatsSnapshot s = snapshot();
+
+    cout << "Bytes gesendet:     " << s.bytes_sent << endl;
+    cout << "Bytes empfangen:    " << s.bytes_received << endl;
+    cout << "Wiederholungen:     " << s.retransmissions << endl;
+    cout << "Checksum-Fehler:    " << s.checksum_errors << endl;
+    if (s.bytes_sent > 0)
     {
         cout << "Fehlerrate:         "
-             << (checksum_errors.load() * 100.0 / bytes_sent.load()) << "%" << endl;
+             << (s.checksum_errors * 100.0 / s.bytes_sent) << "%" << endl;
+    }
+
+    // Ein Histogramm nach dem anderen zusammenführen und ausgeben
+    LatencyHistogram merged_hist;
+    if (count(&StatsShard::symbol_tx) + count(&StatsShard::symbol_rx) +
+            count(&StatsShard::byte_rtt) + message.count() > 0)
+    {
+        cout << "Latenzen:" << endl;
+        merged(&StatsShard::symbol_tx, merged_hist);
+        merged_hist.print("Symbol senden");
+        merged(&StatsShard::symbol_rx, merged_hist);
+        merged_hist.print("Symbol empfangen");
+        merged(&StatsShard::byte_rtt, merged_hist);
+        merged_hist.print("Byte ACK-RTT");
+        message.print("Nachricht");
+    }
+
+    print_overhead(s);
+
+    if (s.credit_stalls > 0)
+    {
+        cout << "Credit-Pausen:      " << s.credit_stalls << " (" << s.credit_wait_ns / 1e6
+             << " ms auf Platz beim Empfaenger gewartet)" << endl;
+    }
+    if (s.write_errors > 0)
+    {
+        cout << "Schreibfehler:      " << s.write_errors << " (Ausgabedatei, Batch erneut versucht)" << endl;
+    }
+
+    if (s.poll_iterations > 0)
+    {
+        uint64_t io_ns = s.io_time_ns;
+        uint64_t sleep_ns = s.sleep_time_ns;
+        uint64_t requested_ns = s.sleep_requested_ns;
+
+        cout << "Poll-Effizienz:" << endl;
+        cout << "  Polls gesamt:       " << s.poll_iterations << endl;
+        cout << "  I/O-Zeit:           " << io_ns / 1e6 << " ms" << endl;
+        cout << "  Schlafzeit:         " << sleep_ns / 1e6 << " ms (angefordert: "
+             << requested_ns / 1e6 << " ms)" << endl;
+        cout << "  Knapp vor Timeout:  " << s.near_timeouts << endl;
+        cout << "  Symbol-Timeouts:    " << s.symbol_timeouts << endl;
+        merged(&StatsShard::polls_per_symbol, merged_hist);
+        merged_hist.print("Polls/Symbol", 1.0, "");
+        merged(&StatsShard::read_io, merged_hist);
+        merged_hist.print("read_input");
+
+        // Grobe Einordnung, woran ein langsamer Link hängt
+        cout << "  Engpass (Schaetzung): ";
+        if (requested_ns > 0 && sleep_ns > requested_ns * 3 / 2)
+        {
+            cout << "Scheduler (Schlafen dauert "
+                 << (double)sleep_ns / requested_ns << "x laenger als angefordert)" << endl;
+        }
+        else if (io_ns > sleep_ns)
+        {
+            cout << "I/O (USB-Registerzugriffe bzw. Mutex)" << endl;
+        }
+        else
+        {
+            cout << "Warten auf Gegenstelle" << endl;
+        }
     }
 }
@@ -0,0 +1,243 @@
+#include "../include/stats_export.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+struct ExportValue
+{
+    const char *name; // ohne "b15_"-Präfix
+    const char *help;
+    const char *type; // "counter" oder "gauge"
+    double value;
+};
+
+struct ExportHistogram
+{
+    const char *name;
+    const char *help;
+    const LatencyHistogram *hist;
+    double divisor; // ns -> s, bzw. 1 für reine Anzahlen
+};
+
+static const struct
+{
+    double q;
+    const char *field;
+} QUANTILES[] = {{0.5, "p50"}, {0.9, "p90"}, {0.99, "p99"}, {0.999, "p999"}};
+
+static string format_number(double v)
+{
+    ostringstream out;
+    out << setprecision(12) << v;
+    return out.str();
+}
+
+// Schreibt über eine temporäre Datei und rename(), damit ein Scraper
+// immer eine vollständige Datei liest
+static bool write_atomic(const string &path, const string &content)
+{
+    string tmp = path + ".tmp";
+    {
+        ofstream out(tmp.c_str(), ios::binary | ios::trunc);
+        if (!out)
+            return false;
+        out << content;
+        if (!out.flush())
+            return false;
+    }
+
+    if (rename(tmp.c_str(), path.c_str()) != 0)
+    {
+        // Windows: rename() überschreibt keine bestehende Datei
+        remove(path.c_str());
+        if (rename(tmp.c_str(), path.c_str()) != 0)
+            return false;
+    }
+    return true;
+}
+
+StatsExporter::StatsExporter(const Stats &s, const string &path_prefix, const string &board)
+    : stats(s), prefix(path_prefix), board_name(board), stopping(false), interval_ms(0)
+{
+    start_ns = latency_now_ns();
+    last_ns = start_ns;
+    last = stats.snapshot();
+}
+
+StatsExporter::~StatsExporter()
+{
+    stop();
+    write_snapshot();
+}
+
+void StatsExporter::start(int interval)
+{
+    if (worker.joinable() || interval <= 0)
+        return;
+
+    interval_ms = interval;
+    stopping = false;
+    worker = thread(&StatsExporter::run, this);
+}
+
+void StatsExporter::stop()
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        stopping = true;
+    }
+    wakeup.notify_all();
+
+    if (worker.joinable())
+        worker.join();
+}
+
+void StatsExporter::run()
+{
+    unique_lock<mutex> lock(mtx);
+    while (!stopping)
+    {
+        wakeup.wait_for(lock, chrono::milliseconds(interval_ms));
+        if (stopping)
+            break;
+
+        lock.unlock();
+        write_snapshot();
+        lock.lock();
+    }
+}
+
+bool StatsExporter::write_snapshot()
+{
+    lock_guard<mutex> lock(write_mutex);
+    uint64_t now_ns = latency_now_ns();
+    StatsSnapshot cur = stats.snapshot();
+
+    double uptime_s = (now_ns - start_ns) / 1e9;
+    double interval_s = (now_ns - last_ns) / 1e9;
+    double tx_rate = interval_s > 0 ? (cur.bytes_sent - last.bytes_sent) / interval_s : 0.0;
+    double rx_rate = interval_s > 0 ? (cur.bytes_received - last.bytes_received) / interval_s : 0.0;
+    double attempts = (double)(cur.bytes_sent + cur.retransmissions);
+    double unix_time = chrono::duration_cast<chrono::milliseconds>(
+                           chrono::system_clock::now().time_since_epoch())
+                           .count() /
+                       1e3;
+
+    last = cur;
+    last_ns = now_ns;
+
+    vector<ExportValue> values = {
+        {"bytes_sent_total", "Bestaetigt gesendete Bytes", "counter", (double)cur.bytes_sent},
+        {"bytes_received_total", "Korrekt empfangene Bytes", "counter", (double)cur.bytes_received},
+        {"payload_bytes_sent_total", "Gesendete Nutzdaten (ohne Steuerbytes)", "counter", (double)cur.payload_sent},
+        {"payload_bytes_received_total", "Empfangene Nutzdaten (ohne Steuerbytes)", "counter", (double)cur.payload_received},
+        {"retransmissions_total", "Wiederholte Bytes", "counter", (double)cur.retransmissions},
+        {"checksum_errors_total", "Empfangene Bytes mit falscher Checksumme", "counter", (double)cur.checksum_errors},
+        {"credit_stalls_total", "Pausen wegen vollem Empfangsfenster der Gegenseite", "counter", (double)cur.credit_stalls},
+        {"credit_wait_seconds_total", "Wartezeit auf Credit", "counter", cur.credit_wait_ns / 1e9},
+        {"poll_iterations_total", "Polls in den Handshake-Schleifen", "counter", (double)cur.poll_iterations},
+        {"io_seconds_total", "Zeit in read_input/write_output", "counter", cur.io_time_ns / 1e9},
+        {"sleep_seconds_total", "Tatsaechlich geschlafene Zeit", "counter", cur.sleep_time_ns / 1e9},
+        {"sleep_requested_seconds_total", "Angeforderte Schlafzeit", "counter", cur.sleep_requested_ns / 1e9},
+        {"near_timeouts_total", "Symbole nach mehr als 80% des Timeouts", "counter", (double)cur.near_timeouts},
+        {"symbol_timeouts_total", "Symbol-Timeouts", "counter", (double)cur.symbol_timeouts},
+        {"write_errors_total", "Fehlgeschlagene Schreibversuche der Ausgabedatei", "counter", (double)cur.write_errors},
+        {"uptime_seconds", "Sekunden seit Start des Exporters", "gauge", uptime_s},
+        {"tx_bytes_per_second", "Sende-Durchsatz seit letzter Momentaufnahme", "gauge", tx_rate},
+        {"rx_bytes_per_second", "Empfangs-Durchsatz seit letzter Momentaufnahme", "gauge", rx_rate},
+        {"retransmission_ratio", "Wiederholungen pro Sendeversuch", "gauge",
+         attempts > 0 ? cur.retransmissions / attempts : 0.0},
+        {"checksum_error_ratio", "Checksum-Fehler pro empfangenem Byte", "gauge",
+         cur.bytes_received + cur.checksum_errors > 0
+             ? (double)cur.checksum_errors / (cur.bytes_received + cur.checksum_errors)
+             : 0.0},
+        {"last_snapshot_timestamp_seconds", "Unix-Zeit der Momentaufnahme", "gauge", unix_time},
+    };
+
+    // Leitungsnutzung je Kategorie; die Namen müssen bis zum Schreiben leben
+    string overhead_names[OVERHEAD_CATEGORIES][2];
+    for (int c = 0; c < OVERHEAD_CATEGORIES; c++)
+    {
+        overhead_names[c][0] = string("overhead_") + overhead_key(c) + "_symbols_total";
+        overhead_names[c][1] = string("overhead_") + overhead_key(c) + "_seconds_total";
+        values.push_back({overhead_names[c][0].c_str(), "Symbole je Overhead-Kategorie", "counter",
+                          (double)cur.overhead_symbols[c]});
+        values.push_back({overhead_names[c][1].c_str(), "Leitungszeit je Overhead-Kategorie", "counter",
+                          cur.overhead_ns[c] / 1e9});
+    }
+
+    // Die Histogramme pro Symbol liegen in den Shards der Threads
+    LatencyHistogram symbol_tx, symbol_rx, byte_rtt, read_io, polls_per_symbol;
+    stats.merged(&StatsShard::symbol_tx, symbol_tx);
+    stats.merged(&StatsShard::symbol_rx, symbol_rx);
+    stats.merged(&StatsShard::byte_rtt, byte_rtt);
+    stats.merged(&StatsShard::read_io, read_io);
+    stats.merged(&StatsShard::polls_per_symbol, polls_per_symbol);
+
+    vector<ExportHistogram> histograms = {
+        {"symbol_tx_seconds", "send_2bits bis ACK-Flanke", &symbol_tx, 1e9},
+        {"symbol_rx_seconds", "receive_2bits bis CLOCK-Flanke", &symbol_rx, 1e9},
+        {"byte_rtt_seconds", "Daten + Checksum bis ACK/NACK", &byte_rtt, 1e9},
+        {"message_seconds", "Erstes Byte bis EOT", &stats.message, 1e9},
+        {"read_io_seconds", "Dauer eines read_input()", &read_io, 1e9},
+        {"polls_per_symbol", "Polls bis zur Flanke", &polls_per_symbol, 1.0},
+    };
+
+    ostringstream json, csv, prom;
+    string label = "{board=\"" + board_name + "\"";
+
+    json << "{\n  \"board\": \"" << board_name << "\",\n  \"metrics\": {";
+    csv << "metric,value\n";
+
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        const ExportValue &v = values[i];
+        json << (i ? "," : "") << "\n    \"" << v.name << "\": " << format_number(v.value);
+        csv << v.name << "," << format_number(v.value) << "\n";
+        prom << "# HELP b15_" << v.name << " " << v.help << "\n"
+             << "# TYPE b15_" << v.name << " " << v.type << "\n"
+             << "b15_" << v.name << label << "} " << format_number(v.value) << "\n";
+    }
+    json << "\n  },\n  \"histograms\": {";
+
+    for (size_t i = 0; i < histograms.size(); i++)
+    {
+        const ExportHistogram &h = histograms[i];
+        uint64_t count = h.hist->count();
+        double sum = h.hist->mean() * count / h.divisor;
+        double max = h.hist->max() / h.divisor;
+
+        json << (i ? "," : "") << "\n    \"" << h.name << "\": {\"count\": " << count
+             << ", \"sum\": " << format_number(sum) << ", \"max\": " << format_number(max);
+        csv << h.name << "_count," << count << "\n"
+            << h.name << "_sum," << format_number(sum) << "\n"
+            << h.name << "_max," << format_number(max) << "\n";
+        prom << "# HELP b15_" << h.name << " " << h.help << "\n"
+             << "# TYPE b15_" << h.name << " summary\n";
+
+        for (const auto &q : QUANTILES)
+        {
+            string value = format_number(count > 0 ? h.hist->percentile(q.q * 100) / h.divisor : 0.0);
+
+            json << ", \"" << q.field << "\": " << value;
+            csv << h.name << "_" << q.field << "," << value << "\n";
+            prom << "b15_" << h.name << label << ",quantile=\"" << format_number(q.q) << "\"} "
+                 << value << "\n";
+        }
+
+        json << "}";
+        prom << "b15_" << h.name << "_sum" << label << "} " << format_number(sum) << "\n"
+             << "b15_" << h.name << "_count" << label << "} " << count << "\n";
+    }
+    json << "\n  }\n}\n";
+
+    bool ok = write_atomic(prefix + ".json", json.str());
+    ok = write_atomic(prefix + ".csv", csv.str()) && ok;
+    ok = write_atomic(prefix + ".prom", prom.str()) && ok;
+    return ok;
+}
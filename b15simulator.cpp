@@ -3,21 +3,58 @@
 #include "checksum.h"
 #include "error_injector.h"
 #include "stats.h"
+#include "trace.h"
+#include "logger.h"
+#include "perf_counters.h"
+#include "usdt.h"
+#include "input_stream.h"
+#include "mapped_file.h"
+#include "message_arena.h"
+#include "raw_output.h"
 #include <iostream>
-#include <fstream>
 #include <bitset>
 #include <thread>
 #include <chrono>
 
 using namespace std;
 
-B15Simulator::B15Simulator(bool is_a, bool verb) : is_board_a(is_a), verbose(verb)
+// USDT-Probes, siehe usdt.h. Argumente:
+B15_PROBE_SEMAPHORE(symbol_tx);   // Nibble, Polls, ns bis ACK-Flanke
+B15_PROBE_SEMAPHORE(symbol_rx);   // 2 Datenbits, Polls, ns bis CLOCK-Flanke
+B15_PROBE_SEMAPHORE(byte_tx);     // Byte, Wiederholungen, ns, 1 bei ACK
+B15_PROBE_SEMAPHORE(byte_rx);     // Byte, 1 bei gültiger Checksum, ns ab 1. Symbol
+B15_PROBE_SEMAPHORE(retry);       // Byte, Versuch
+B15_PROBE_SEMAPHORE(timeout);     // 0 senden / 1 empfangen, Polls
+B15_PROBE_SEMAPHORE(message_rx);  // Länge in Bytes, ns erstes Byte bis EOT
+
+B15Simulator::B15Simulator(bool is_a, bool verb)
+    : is_board_a(is_a), own_cable(new PatchCableFile()), cable(own_cable.get()), verbose(verb)
 {
-    name = is_a ? "Board A" : "Board B";
+    init();
+}
+
+B15Simulator::B15Simulator(bool is_a, PatchCable &shared_cable, bool verb)
+    : is_board_a(is_a), cable(&shared_cable), verbose(verb)
+{
+    init();
+}
+
+void B15Simulator::init()
+{
+    name = is_board_a ? "Board A" : "Board B";
+
+    scenario = nullptr;
+    stats = &global_stats;
+    injector = &error_injector;
 
     current_clock_state = 0;
     current_ack_state = 0;
 
+    rx_consumer = nullptr;
+    tx_credit = -1;
+    tx_channel_id = false;
+    rx_channel_id = false;
+
     this_thread::sleep_for(chrono::milliseconds(200));
 
     uint8_t initial = read_input();
@@ -26,43 +63,154 @@ B15Simulator::B15Simulator(bool is_a, bool verb) : is_board_a(is_a), verbose(ver
 
     write_output(0);
 
-    cout << "[" << name << "] Initialisiert!" << endl;
+    LOG_INFO("[" << name << "] Initialisiert!");
+}
+
+void B15Simulator::set_protocol_settings(const ProtocolSettings &s)
+{
+    settings = s;
+}
+
+void B15Simulator::set_writer_settings(const WriterSettings &s)
+{
+    writer_settings = s;
+}
+
+const WriterSettings &B15Simulator::get_writer_settings() const
+{
+    return writer_settings;
+}
+
+void B15Simulator::set_spill_settings(const SpillSettings &s)
+{
+    spill_settings = s;
+}
+
+const SpillSettings &B15Simulator::get_spill_settings() const
+{
+    return spill_settings;
+}
+
+void B15Simulator::set_flow_settings(const FlowSettings &s)
+{
+    flow_settings = s;
+}
+
+const FlowSettings &B15Simulator::get_flow_settings() const
+{
+    return flow_settings;
+}
+
+void B15Simulator::set_rx_consumer(BacklogSource *consumer)
+{
+    rx_consumer = consumer;
+}
+
+void B15Simulator::set_stats(Stats *s)
+{
+    stats = s;
+}
+
+void B15Simulator::set_error_injector(ErrorInjector *e)
+{
+    injector = e;
+}
+
+Stats &B15Simulator::get_stats()
+{
+    return *stats;
 }
 
 void B15Simulator::write_output(uint8_t data)
 {
+    uint64_t start_ns = latency_now_ns();
+
     if (is_board_a)
     {
-        cable.write_bits_a(data & 0x0F);
+        cable->write_bits_a(data & 0x0F);
         if (verbose)
         {
-            cout << "  [" << name << "] -> " << bitset<4>(data & 0x0F) << endl;
+            LOG_TRACE("  [" << name << "] -> " << bitset<4>(data & 0x0F));
         }
     }
     else
     {
-        cable.write_bits_b(data & 0x0F);
+        cable->write_bits_b(data & 0x0F);
         if (verbose)
         {
-            cout << "  [" << name << "] -> " << bitset<4>(data & 0x0F) << endl;
+            LOG_TRACE("  [" << name << "] -> " << bitset<4>(data & 0x0F));
         }
     }
+
+    stats->io_time_ns += latency_now_ns() - start_ns;
 }
 
 uint8_t B15Simulator::read_input()
 {
+    uint64_t start_ns = latency_now_ns();
+    uint8_t value;
+
     if (is_board_a)
     {
-        return cable.read_bits_b(); // Board A reads from Board B's bits
+        value = cable->read_bits_b(); // Board A reads from Board B's bits
     }
     else
     {
-        return cable.read_bits_a(); // Board B reads from Board A's bits
+        value = cable->read_bits_a(); // Board B reads from Board A's bits
+    }
+
+    uint64_t elapsed_ns = latency_now_ns() - start_ns;
+    stats->io_time_ns += elapsed_ns;
+    stats->read_io.record(elapsed_ns);
+    return value;
+}
+
+void B15Simulator::poll_sleep()
+{
+    uint64_t start_ns = latency_now_ns();
+    this_thread::sleep_for(chrono::microseconds(settings.poll_interval_us));
+    stats->sleep_time_ns += latency_now_ns() - start_ns;
+    stats->sleep_requested_ns += settings.poll_interval_us * 1000ULL;
+}
+
+void B15Simulator::record_polls(int polls, bool completed)
+{
+    stats->poll_iterations += polls;
+    if (!completed)
+    {
+        stats->symbol_timeouts++;
+        return;
+    }
+
+    stats->polls_per_symbol.record(polls);
+    if (polls * 10 > settings.timeout_polls * 8)
+    {
+        stats->near_timeouts++;
+    }
+}
+
+WireFaultModel &B15Simulator::incoming_wire_faults()
+{
+    return is_board_a ? cable->wire_faults_b() : cable->wire_faults_a();
+}
+
+void B15Simulator::set_fault_scenario(FaultScenario *s)
+{
+    scenario = s;
+}
+
+void B15Simulator::update_scenario()
+{
+    if (scenario)
+    {
+        scenario->update(stats->bytes_sent + stats->bytes_received,
+                         *injector, incoming_wire_faults());
     }
 }
 
 bool B15Simulator::send_2bits(uint8_t data)
 {
+    PerfScope perf(PERF_REGION_SYMBOL_TX);
     data &= 0x03;
 
     uint8_t output = current_ack_state;
@@ -74,9 +222,11 @@ bool B15Simulator::send_2bits(uint8_t data)
     current_clock_state ^= CLOCK;
     output |= current_clock_state;
 
+    uint64_t start_ns = latency_now_ns();
     write_output(output);
+    trace(TRACE_SYMBOL_SENT, output);
 
-    for (int i = 0; i < 5000; i++)
+    for (int i = 0; i < settings.timeout_polls; i++)
     {
         uint8_t input = read_input();
         uint8_t received_ack = input & ACK;
@@ -84,18 +234,29 @@ bool B15Simulator::send_2bits(uint8_t data)
         if (received_ack != last_received_ack)
         {
             last_received_ack = received_ack;
+            trace(TRACE_ACK_TOGGLE, received_ack ? 1 : 0, i + 1);
+            uint64_t elapsed_ns = latency_now_ns() - start_ns;
+            stats->symbol_tx.record(elapsed_ns);
+            record_polls(i + 1, true);
+            B15_PROBE3(symbol_tx, output, i + 1, elapsed_ns);
             return true;
         }
 
-        this_thread::sleep_for(chrono::microseconds(100));
+        poll_sleep();
     }
 
+    trace(TRACE_TIMEOUT, 0);
+    record_polls(settings.timeout_polls, false);
+    B15_PROBE2(timeout, 0, settings.timeout_polls);
     return false;
 }
 
 uint8_t B15Simulator::receive_2bits()
 {
-    for (int i = 0; i < 5000; i++)
+    PerfScope perf(PERF_REGION_SYMBOL_RX);
+    uint64_t start_ns = latency_now_ns();
+
+    for (int i = 0; i < settings.timeout_polls; i++)
     {
         uint8_t input = read_input();
         uint8_t received_clock = input & CLOCK;
@@ -114,13 +275,21 @@ uint8_t B15Simulator::receive_2bits()
             uint8_t output = current_ack_state | current_clock_state;
 
             write_output(output);
+            trace(TRACE_SYMBOL_RECEIVED, data, i + 1);
+            uint64_t elapsed_ns = latency_now_ns() - start_ns;
+            stats->symbol_rx.record(elapsed_ns);
+            record_polls(i + 1, true);
+            B15_PROBE3(symbol_rx, data, i + 1, elapsed_ns);
 
             return data;
         }
 
-        this_thread::sleep_for(chrono::microseconds(100));
+        poll_sleep();
     }
 
+    trace(TRACE_TIMEOUT, 1);
+    record_polls(settings.timeout_polls, false);
+    B15_PROBE2(timeout, 1, settings.timeout_polls);
     return 0xFF;
 }
 
@@ -137,185 +306,427 @@ bool B15Simulator::send_byte_raw(uint8_t byte)
     return true;
 }
 
-uint8_t B15Simulator::receive_byte_raw()
+// Timeout wird über den Rückgabewert gemeldet, nicht im Byte: alle 256
+// Werte sind gültig, z.B. die Checksum 0xFF von 0xB7. byte bleibt bei
+// einem Timeout unverändert. first_symbol_ns = Ankunft des 1. Symbols.
+bool B15Simulator::receive_byte_raw(uint8_t &byte, uint64_t *first_symbol_ns)
 {
-    uint8_t byte = 0;
+    uint8_t value = 0;
     uint8_t part;
 
     part = receive_2bits();
     if (part == 0xFF)
-        return 0xFF;
-    byte |= (part << 0);
+        return false;
+    value |= (part << 0);
+    if (first_symbol_ns)
+        *first_symbol_ns = latency_now_ns();
 
     part = receive_2bits();
     if (part == 0xFF)
-        return 0xFF;
-    byte |= (part << 2);
+        return false;
+    value |= (part << 2);
 
     part = receive_2bits();
     if (part == 0xFF)
-        return 0xFF;
-    byte |= (part << 4);
+        return false;
+    value |= (part << 4);
 
     part = receive_2bits();
     if (part == 0xFF)
-        return 0xFF;
-    byte |= (part << 6);
+        return false;
+    value |= (part << 6);
+
+    byte = value;
+    return true;
+}
+
+// "Board B" -> "B", für Dateinamen
+static string board_letter(const string &name)
+{
+    return name.substr(name.find(' ') + 1);
+}
+
+// Steuerbytes getrennt von Nutzdaten ausweisen. channel_id merkt sich pro
+// Richtung, dass nach CHANNEL_BYTE noch die (ggf. maskierte) Kanalnummer
+// folgt, die ebenfalls zum Kanalwechsel zählt.
+static OverheadCategory overhead_category(uint8_t byte, bool &channel_id)
+{
+    if (byte == ABORT_BYTE)
+    {
+        channel_id = false;
+        return OVERHEAD_EOT;
+    }
+    if (channel_id)
+    {
+        channel_id = (byte == ESC_BYTE);
+        return OVERHEAD_CHANNEL;
+    }
+    if (byte == CHANNEL_BYTE)
+    {
+        channel_id = true;
+        return OVERHEAD_CHANNEL;
+    }
+    if (byte == EOT_BYTE)
+        return OVERHEAD_EOT;
+    if (byte == ESC_BYTE)
+        return OVERHEAD_ESCAPE;
+    if (byte == PROBE_BYTE)
+        return OVERHEAD_PROBE;
+    return OVERHEAD_PAYLOAD;
+}
+
+// ACK_BYTE ohne Verbraucher, sonst mit dem freien Platz im Empfangsfenster
+uint8_t B15Simulator::ack_byte()
+{
+    if (!rx_consumer || flow_settings.rx_window == 0)
+        return ACK_BYTE;
 
-    return byte;
+    // Mindestens eine Einheit, sonst käme bei leerem Puffer nie Credit
+    size_t window = flow_settings.rx_window > CREDIT_UNIT ? flow_settings.rx_window : CREDIT_UNIT;
+    size_t backlog = rx_consumer->backlog();
+    return credit_ack(backlog < window ? window - backlog : 0);
 }
 
 bool B15Simulator::send_byte_with_checksum(uint8_t byte)
 {
+    TraceScope span(TRACE_BYTE_TX_BEGIN, TRACE_BYTE_TX_END, byte);
+    PerfScope perf(PERF_REGION_BYTE_TX);
+    update_scenario();
+
     uint8_t checksum = calculate_checksum(byte);
+    uint64_t byte_start_ns = B15_PROBE_ENABLED(byte_tx) ? latency_now_ns() : 0;
 
-    for (int retry = 0; retry < MAX_RETRIES; retry++)
+    for (int retry = 0; retry < settings.max_retries; retry++)
     {
         if (retry > 0)
         {
-            cout << "[" << name << "] WIEDERHOLUNG " << retry << "/" << MAX_RETRIES << endl;
-            global_stats.retransmissions++;
+            LOG_DEBUG("[" << name << "] WIEDERHOLUNG " << retry << "/" << settings.max_retries);
+            stats->retransmissions++;
+            trace(TRACE_RETRY, retry);
+            B15_PROBE2(retry, byte, retry);
         }
 
-        cout << "[" << name << "] Sende Byte: '" << (char)byte << "' (0x"
-             << hex << (int)byte << dec << ") + Checksum: 0x"
-             << hex << (int)checksum << dec << endl;
+        LOG_DEBUG("[" << name << "] Sende Byte: '" << (char)byte << "' (0x"
+                      << hex << (int)byte << dec << ") + Checksum: 0x"
+                      << hex << (int)checksum << dec);
+
+        uint64_t attempt_start_ns = latency_now_ns();
 
         // Sende Daten-Byte
         if (!send_byte_raw(byte))
         {
-            cerr << "[" << name << "] Fehler beim Senden!" << endl;
+            LOG_WARN("[" << name << "] Fehler beim Senden!");
+            B15_PROBE4(byte_tx, byte, retry, latency_now_ns() - byte_start_ns, 0);
+            trace(TRACE_LINK_FAILED, byte);
+            trace_dump();
             return false;
         }
 
+        uint64_t checksum_start_ns = latency_now_ns();
+
         // Sende Checksum
         if (!send_byte_raw(checksum))
         {
-            cerr << "[" << name << "] Fehler beim Senden der Checksum!" << endl;
+            LOG_WARN("[" << name << "] Fehler beim Senden der Checksum!");
+            B15_PROBE4(byte_tx, byte, retry, latency_now_ns() - byte_start_ns, 0);
+            trace(TRACE_LINK_FAILED, byte);
+            trace_dump();
             return false;
         }
 
         // Warte auf ACK/NACK
-        uint8_t response = receive_byte_raw();
+        uint64_t response_start_ns = latency_now_ns();
+        uint8_t response = 0;
+        bool answered = receive_byte_raw(response);
+        uint64_t end_ns = latency_now_ns();
+        if (answered)
+        {
+            stats->byte_rtt.record(end_ns - attempt_start_ns);
+        }
 
-        if (response == ACK_BYTE)
+        if (!is_ack(response))
         {
-            cout << "[" << name << "] << ACK empfangen! Byte erfolgreich uebertragen." << endl;
-            global_stats.bytes_sent++;
+            stats->add_overhead(OVERHEAD_RETRANSMIT, answered ? 12 : 8, end_ns - attempt_start_ns);
+        }
+
+        if (is_ack(response))
+        {
+            tx_credit = ack_credit(response);
+            OverheadCategory category = overhead_category(byte, tx_channel_id);
+            stats->add_overhead(category, 4, checksum_start_ns - attempt_start_ns);
+            stats->add_overhead(OVERHEAD_CHECKSUM, 4, response_start_ns - checksum_start_ns);
+            stats->add_overhead(OVERHEAD_ACK, 4, end_ns - response_start_ns);
+            LOG_DEBUG("[" << name << "] << ACK empfangen! Byte erfolgreich uebertragen.");
+            stats->bytes_sent++;
+            if (category == OVERHEAD_PAYLOAD)
+                stats->payload_sent++;
+            span.set_result(byte, 1);
+            B15_PROBE4(byte_tx, byte, retry, end_ns - byte_start_ns, 1);
             return true;
         }
         else if (response == NACK_BYTE)
         {
-            cout << "[" << name << "] << NACK empfangen! Checksum-Fehler, wiederhole..." << endl;
+            trace(TRACE_NACK, retry);
+            LOG_DEBUG("[" << name << "] << NACK empfangen! Checksum-Fehler, wiederhole...");
         }
         else
         {
-            cout << "[" << name << "] << Unerwartete Antwort: 0x" << hex << (int)response << dec << endl;
+            LOG_DEBUG("[" << name << "] << Unerwartete Antwort: 0x" << hex << (int)response << dec);
         }
     }
 
-    cerr << "[" << name << "] XXX MAX RETRIES erreicht! Uebertragung fehlgeschlagen." << endl;
+    LOG_ERROR("[" << name << "] XXX MAX RETRIES erreicht! Uebertragung fehlgeschlagen.");
+    B15_PROBE4(byte_tx, byte, settings.max_retries, latency_now_ns() - byte_start_ns, 0);
+    trace(TRACE_LINK_FAILED, byte);
+    trace_dump();
     return false;
 }
 
 uint8_t B15Simulator::receive_byte_with_checksum()
 {
-    cout << "\n[" << name << "] Warte auf Byte..." << endl;
+    TraceScope span(TRACE_BYTE_RX_BEGIN, TRACE_BYTE_RX_END);
+    PerfScope perf(PERF_REGION_BYTE_RX);
+    update_scenario();
 
-    // Empfange Daten-Byte (mit Fehler-Injektion!)
-    uint8_t byte = receive_byte_raw();
-    if (byte == 0xFF)
+    LOG_TRACE("[" << name << "] Warte auf Byte...");
+
+    // Empfange Daten-Byte (mit Fehler-Injektion!). Die Wartezeit auf das
+    // erste Symbol ist Leerlauf und zählt nicht zur Leitungsnutzung.
+    uint64_t start_ns = 0;
+    uint8_t byte;
+    if (!receive_byte_raw(byte, &start_ns))
     {
-        cerr << "[" << name << "] Timeout beim Empfangen!" << endl;
+        LOG_DEBUG("[" << name << "] Timeout beim Empfangen!");
         return 0xFF;
     }
+    uint64_t checksum_start_ns = latency_now_ns();
 
     // Fehler-Injektion hier!
-    uint8_t received_byte = error_injector.inject_error(byte);
+    uint8_t received_byte = injector->inject_error(byte);
 
     // Empfange Checksum
-    uint8_t received_checksum = receive_byte_raw();
-    if (received_checksum == 0xFF)
+    uint8_t received_checksum;
+    if (!receive_byte_raw(received_checksum))
     {
-        cerr << "[" << name << "] Timeout beim Empfangen der Checksum!" << endl;
+        LOG_DEBUG("[" << name << "] Timeout beim Empfangen der Checksum!");
+        stats->add_overhead(OVERHEAD_RETRANSMIT, 4, latency_now_ns() - start_ns);
         return 0xFF;
     }
+    uint64_t response_start_ns = latency_now_ns();
 
     // Berechne erwartete Checksum
     uint8_t expected_checksum = calculate_checksum(received_byte);
 
-    cout << "[" << name << "] Empfangen: 0x" << hex << (int)received_byte << dec
-         << ", Checksum: 0x" << hex << (int)received_checksum << dec
-         << " (erwartet: 0x" << hex << (int)expected_checksum << dec << ")" << endl;
+    LOG_DEBUG("[" << name << "] Empfangen: 0x" << hex << (int)received_byte << dec
+                  << ", Checksum: 0x" << hex << (int)received_checksum << dec
+                  << " (erwartet: 0x" << hex << (int)expected_checksum << dec << ")");
 
     if (received_checksum == expected_checksum)
     {
-        cout << "[" << name << "] >> Checksum OK! Sende ACK." << endl;
-        send_byte_raw(ACK_BYTE);
-        global_stats.bytes_received++;
+        LOG_DEBUG("[" << name << "] >> Checksum OK! Sende ACK.");
+        send_byte_raw(ack_byte());
+        OverheadCategory category = overhead_category(received_byte, rx_channel_id);
+        stats->add_overhead(category, 4, checksum_start_ns - start_ns);
+        stats->add_overhead(OVERHEAD_CHECKSUM, 4, response_start_ns - checksum_start_ns);
+        uint64_t end_ns = latency_now_ns();
+        stats->add_overhead(OVERHEAD_ACK, 4, end_ns - response_start_ns);
+        stats->bytes_received++;
+        if (category == OVERHEAD_PAYLOAD)
+            stats->payload_received++;
+        span.set_result(received_byte, 1);
+        B15_PROBE3(byte_rx, received_byte, 1, end_ns - start_ns);
         return received_byte;
     }
     else
     {
-        cout << "[" << name << "] XX Checksum FEHLER! Sende NACK." << endl;
+        LOG_DEBUG("[" << name << "] XX Checksum FEHLER! Sende NACK.");
+        trace(TRACE_CHECKSUM_ERROR, received_byte, received_checksum);
         send_byte_raw(NACK_BYTE);
-        global_stats.checksum_errors++;
+        uint64_t end_ns = latency_now_ns();
+        stats->add_overhead(OVERHEAD_RETRANSMIT, 12, end_ns - start_ns);
+        stats->checksum_errors++;
+        B15_PROBE3(byte_rx, received_byte, 0, end_ns - start_ns);
         return 0xFF; // Signalisiert Fehler
     }
 }
 
+bool B15Simulator::wait_for_credit()
+{
+    if (!credit_blocked())
+    {
+        return true;
+    }
+
+    LOG_DEBUG("[" << name << "] Empfaenger hat keinen Platz, warte auf Credit");
+    uint64_t start_ns = latency_now_ns();
+    stats->credit_stalls++;
+    bool ok = true;
+    while (ok && credit_blocked())
+    {
+        this_thread::sleep_for(chrono::milliseconds(flow_settings.probe_interval_ms));
+        ok = send_byte_with_checksum(PROBE_BYTE);
+    }
+    stats->credit_wait_ns += latency_now_ns() - start_ns;
+    return ok;
+}
+
+// Sendet ein Nutzdaten-Byte, maskiert falls nötig (siehe stuff_byte). Bei
+// vollem Empfangsfenster wird vorher gewartet, nie zwischen ESC und Byte.
+bool B15Simulator::send_payload_byte(uint8_t byte)
+{
+    if (!wait_for_credit())
+        return false;
+
+    uint8_t wire[2];
+    int n = stuff_byte(byte, wire);
+    for (int i = 0; i < n; i++)
+    {
+        if (!send_byte_with_checksum(wire[i]))
+            return false;
+    }
+    return true;
+}
+
 void B15Simulator::run_sender_mode()
 {
+    AsyncLogger::instance().flush();
     cout << "\n[" << name << "] INTERAKTIVER MODUS (mit ARQ)" << endl;
     cout << "[" << name << "] Gib Nachrichten ein (eine pro Zeile):" << endl;
     cout << "[" << name << "] Jede Zeile wird komplett gesendet + EOT" << endl;
 
-    string line;
-    while (getline(cin, line))
+    // Eingabe wird gestreamt: jedes Byte geht raus, sobald es gelesen ist,
+    // auch bei Binärdaten. Nachrichtengrenze ist weiterhin '\n', der Rest
+    // nach dem letzten '\n' wird bei EOF als eigene Nachricht abgeschlossen.
+    InputStream input;
+    uint8_t block[4096];
+    size_t message_bytes = 0;
+    uint64_t message_start_ns = 0;
+    bool ok = true;
+
+    size_t n;
+    while (ok && (n = input.read(block, sizeof(block))) > 0)
     {
-        cout << "[" << name << "] Sende Nachricht: \"" << line << "\"" << endl;
-
-        // Sende alle Zeichen der Zeile
-        for (char c : line)
+        for (size_t i = 0; i < n && ok; i++)
         {
-            if (!send_byte_with_checksum(c))
+            if (message_bytes == 0)
             {
-                cerr << "[" << name << "] Uebertragung abgebrochen!" << endl;
-                global_stats.print();
-                return;
+                message_start_ns = latency_now_ns();
             }
-        }
+            stats->tx_queue_bytes = input.buffered() + (n - i);
 
-        // Sende Newline
-        if (!send_byte_with_checksum('\n'))
-        {
-            cerr << "[" << name << "] Uebertragung abgebrochen!" << endl;
-            global_stats.print();
-            return;
-        }
+            ok = send_payload_byte(block[i]);
+            message_bytes++;
 
-        // Sende EOT (End of Transmission)
-        cout << "[" << name << "] Sende EOT (End of Transmission)" << endl;
-        if (!send_byte_with_checksum(EOT_BYTE))
-        {
-            cerr << "[" << name << "] Uebertragung abgebrochen!" << endl;
-            global_stats.print();
-            return;
+            if (ok && block[i] == '\n')
+            {
+                ok = finish_message(message_bytes, message_start_ns);
+                message_bytes = 0;
+            }
         }
+    }
 
-        cout << "[" << name << "] >>> Nachricht komplett gesendet! <<<\n"
-             << endl;
+    if (ok && message_bytes > 0)
+    {
+        ok = finish_message(message_bytes, message_start_ns);
     }
+    stats->tx_queue_bytes = 0;
 
-    global_stats.print();
+    if (!ok)
+    {
+        LOG_ERROR("[" << name << "] Uebertragung abgebrochen!");
+        send_abort();
+    }
+    AsyncLogger::instance().flush();
+    stats->print();
+}
+
+// Nutzdaten am Stück, z.B. ein Ausschnitt einer eingeblendeten Datei.
+// Liest direkt aus data, es wird nichts kopiert.
+bool B15Simulator::send_block(const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        if (!send_payload_byte(data[i]))
+            return false;
+    }
+    return true;
+}
+
+void B15Simulator::run_send_file_mode(const string &path)
+{
+    AsyncLogger::instance().flush();
+
+    MappedFile file;
+    string error;
+    if (!file.load(path, error))
+    {
+        cerr << "[" << name << "] " << error << endl;
+        return;
+    }
+
+    cout << "\n[" << name << "] DATEI-MODUS (mit ARQ)" << endl;
+    cout << "[" << name << "] Sende " << path << " (" << file.size() << " Bytes) als eine Nachricht + EOT" << endl;
+
+    // Die Datei geht in Ausschnitten an send_block(); tx_queue_bytes zeigt
+    // den noch nicht gesendeten Rest
+    const size_t SLICE = 4096;
+    uint64_t message_start_ns = latency_now_ns();
+    bool ok = true;
+
+    for (size_t offset = 0; ok && offset < file.size(); offset += SLICE)
+    {
+        size_t len = min(SLICE, file.size() - offset);
+        stats->tx_queue_bytes = file.size() - offset;
+        ok = send_block(file.data() + offset, len);
+    }
+
+    if (ok)
+    {
+        ok = finish_message(file.size(), message_start_ns);
+    }
+    stats->tx_queue_bytes = 0;
+
+    if (!ok)
+    {
+        LOG_ERROR("[" << name << "] Uebertragung abgebrochen!");
+        send_abort();
+    }
+    AsyncLogger::instance().flush();
+    stats->print();
+}
+
+// Nach einem Fehler mitten in einer Nachricht, damit der Empfänger den
+// angefangenen Teil verwirft statt ihn beim nächsten EOT auszuliefern
+bool B15Simulator::send_abort()
+{
+    LOG_WARN("[" << name << "] Sende ABORT, Empfaenger verwirft die angefangene Nachricht");
+    return send_byte_with_checksum(ABORT_BYTE);
+}
+
+bool B15Simulator::finish_message(size_t message_bytes, uint64_t message_start_ns)
+{
+    // Sende EOT (End of Transmission)
+    LOG_DEBUG("[" << name << "] Sende EOT (End of Transmission)");
+    if (!send_byte_with_checksum(EOT_BYTE))
+    {
+        return false;
+    }
+
+    stats->message.record(latency_now_ns() - message_start_ns);
+    LOG_INFO("[" << name << "] >>> Nachricht komplett gesendet (" << message_bytes << " Bytes) <<<\n");
+    return true;
 }
 
 void B15Simulator::run_receiver_mode()
 {
+    AsyncLogger::instance().flush();
     cout << "\n[" << name << "]  EMPFANGSMODUS (mit ARQ)" << endl;
     cout << "[" << name << "] Warte auf Nachrichten (bis EOT)..." << endl;
 
-    string received_message = "";
+    ChannelArenas received(spill_settings, board_letter(name)); // Pro Kanal, zu große Nachrichten als Spill-Datei
+    uint64_t start_ns[MAX_CHANNELS] = {};
+    Unstuffer unstuffer;
+    ChannelTracker channels;
 
     while (true)
     {
@@ -327,23 +738,140 @@ void B15Simulator::run_receiver_mode()
             continue;
         }
 
+        Unstuffer::Kind kind = unstuffer.feed(byte);
+        if (kind == Unstuffer::PENDING || !channels.feed(kind, byte))
+        {
+            continue;
+        }
+
+        if (kind == Unstuffer::CONTROL && byte == ABORT_BYTE)
+        {
+            LOG_WARN("[" << name << "] ABORT empfangen, angefangene Nachrichten verworfen");
+            received.reset();
+            for (int i = 0; i < MAX_CHANNELS; i++)
+            {
+                start_ns[i] = 0;
+            }
+            continue;
+        }
+
+        // Nachrichten verschiedener Kanäle können sich abwechseln
+        int channel = channels.current();
+        MessageArena &received_message = received[channel];
+        uint64_t &message_start_ns = start_ns[channel];
+        if (message_start_ns == 0)
+        {
+            message_start_ns = latency_now_ns();
+        }
+
         // Prüfe auf EOT (End of Transmission)
-        if (byte == EOT_BYTE)
+        if (kind == Unstuffer::CONTROL && byte == EOT_BYTE)
         {
-            cout << "[" << name << "] EOT empfangen! Nachricht komplett." << endl;
-            cout << "[" << name << "] EMPFANGENE NACHRICHT:" << endl;
-            cout << ">>> " << received_message << " <<<" << endl;
+            LOG_INFO("[" << name << "] EOT empfangen! Nachricht komplett.");
+            uint64_t message_size = received_message.size();
+            // Außerhalb von LOG_INFO: übernimmt auch eine Spill-Datei
+            string note;
+            ByteSpan message = received_message.take_message(note);
+            LOG_INFO("[" << name << "] EMPFANGENE NACHRICHT:");
+            LOG_INFO(">>> " << message << " <<<");
+            uint64_t message_ns = latency_now_ns() - message_start_ns;
+            stats->message.record(message_ns);
+            B15_PROBE2(message_rx, message_size, message_ns);
 
             // Reset für nächste Nachricht
-            received_message = "";
+            received_message.reset();
+            message_start_ns = 0;
             continue;
         }
 
         // Sammle Zeichen
-        received_message += (char)byte;
-        cout << "[" << name << "] Zeichen empfangen: '" << (char)byte
-             << "' (Message bisher: \"" << received_message << "\")" << endl;
+        received_message.push(byte);
+        LOG_DEBUG("[" << name << "] Zeichen empfangen: '" << (char)byte
+                      << "' (Message bisher: " << received_message.size() << " Bytes)");
+    }
+}
+
+// Wie run_receiver_mode, aber ohne Nachrichtenpuffer: Nutzdaten gehen in
+// Stücken von höchstens FRAME_BYTES in den Ausgabepuffer, spätestens bei
+// EOT, ABORT oder ruhiger Leitung; EOT leert ihn. Meldungen müssen dafür
+// auf stderr umgeleitet sein (siehe main.cpp).
+void B15Simulator::run_raw_receiver_mode()
+{
+    LOG_INFO("[" << name << "] EMPFANGSMODUS (roh, Nutzdaten auf stdout)");
+
+    RawOutput out;
+    set_rx_consumer(&out); // Langsame Pipe bremst den Sender über die Credits
+    uint64_t message_start_ns = 0;
+    uint64_t message_bytes = 0;
+    Unstuffer unstuffer;
+    ChannelTracker channels; // Kanalwechsel werden übergangen, die Kanäle nicht getrennt
+    uint8_t pending[FRAME_BYTES];
+    size_t pending_len = 0;
+    auto push_pending = [&]()
+    {
+        if (pending_len > 0)
+        {
+            out.write(pending, pending_len);
+            pending_len = 0;
+        }
+    };
+
+    while (out.ok())
+    {
+        uint8_t byte = receive_byte_with_checksum();
+
+        if (byte == 0xFF)
+        {
+            push_pending(); // Nichts kommt nach, Gesammeltes nicht liegen lassen
+            continue;
+        }
+
+        Unstuffer::Kind kind = unstuffer.feed(byte);
+        if (kind == Unstuffer::PENDING || !channels.feed(kind, byte))
+        {
+            continue;
+        }
+
+        if (kind == Unstuffer::CONTROL && byte == ABORT_BYTE)
+        {
+            // Schon ausgegebene Bytes lassen sich nicht zurückholen
+            push_pending();
+            LOG_WARN("[" << name << "] ABORT empfangen, Nachricht nach " << message_bytes
+                         << " ausgegebenen Bytes abgebrochen");
+            message_start_ns = 0;
+            message_bytes = 0;
+            continue;
+        }
+
+        if (message_start_ns == 0)
+        {
+            message_start_ns = latency_now_ns();
+        }
+
+        if (kind == Unstuffer::CONTROL && byte == EOT_BYTE)
+        {
+            push_pending();
+            out.flush();
+            uint64_t message_ns = latency_now_ns() - message_start_ns;
+            stats->message.record(message_ns);
+            B15_PROBE2(message_rx, message_bytes, message_ns);
+            LOG_DEBUG("[" << name << "] EOT, " << message_bytes << " Bytes ausgegeben");
+
+            message_start_ns = 0;
+            message_bytes = 0;
+            continue;
+        }
+
+        pending[pending_len++] = byte;
+        message_bytes++;
+        if (pending_len == sizeof(pending))
+        {
+            push_pending();
+        }
     }
+
+    set_rx_consumer(nullptr);
+    LOG_WARN("[" << name << "] stdout geschlossen, Empfang beendet");
 }
 
 // ==================== FULL-DUPLEX MODE ====================
@@ -356,80 +884,255 @@ struct FullDuplexThreadData
     B15Simulator *sim;
     volatile bool *running;
     pthread_mutex_t *cable_mutex;
+    LinkDaemon *daemon; // Gesetzt im Daemon-Modus, sonst nullptr
 };
 
-void *fullduplex_tx_thread(void *arg)
+// Wartezeit und Haltedauer des Kabel-Mutex landen im Trace
+static void lock_cable(pthread_mutex_t *mutex)
 {
-    FullDuplexThreadData *data = (FullDuplexThreadData *)arg;
-    B15Simulator *sim = data->sim;
-    pthread_mutex_t *mutex = data->cable_mutex;
+    trace(TRACE_LOCK_WAIT, TRACE_LOCK_CABLE);
+    pthread_mutex_lock(mutex);
+    trace(TRACE_LOCK_ACQUIRED, TRACE_LOCK_CABLE);
+}
 
-    cout << "\n[" << sim->name << " TX] SENDEMODUS (Full-Duplex)" << endl;
-    cout << "[" << sim->name << " TX] Gib Nachrichten ein (Ctrl+C zum Beenden):" << endl;
+static void unlock_cable(pthread_mutex_t *mutex)
+{
+    pthread_mutex_unlock(mutex);
+    trace(TRACE_LOCK_RELEASED, TRACE_LOCK_CABLE);
+}
 
-    string message;
-    while (*(data->running))
+// Ein Byte mit Mutex-Schutz senden, bei Fehlern bis zu MAX_RETRIES Anläufe
+static bool send_with_retries(B15Simulator *sim, pthread_mutex_t *mutex, uint8_t byte)
+{
+    for (int retry = 0; retry < MAX_RETRIES; ++retry)
     {
-        cout << "[" << sim->name << " TX] Eingabe: ";
-        if (!getline(cin, message))
+        if (retry > 0)
         {
-            break;
+            LOG_DEBUG("[" << sim->name << " TX] Retry " << retry << " fuer Byte '" << (char)byte << "'");
         }
 
-        if (message.empty())
+        lock_cable(mutex);
+        bool success = sim->send_byte_with_checksum(byte);
+        unlock_cable(mutex);
+
+        if (success)
         {
-            continue;
+            return true;
         }
+        this_thread::sleep_for(chrono::milliseconds(10));
+    }
+    return false;
+}
+
+// Wie B15Simulator::wait_for_credit(), das Kabel aber nur für die einzelnen
+// Nachfragen sperren, damit der RX-Thread dazwischen weiterläuft
+static bool wait_for_credit(B15Simulator *sim, pthread_mutex_t *mutex)
+{
+    if (!sim->credit_blocked())
+    {
+        return true;
+    }
+
+    LOG_DEBUG("[" << sim->name << " TX] Empfaenger hat keinen Platz, warte auf Credit");
+    Stats &stats = sim->get_stats();
+    uint64_t start_ns = latency_now_ns();
+    stats.credit_stalls++;
+    bool ok = true;
+    while (ok && sim->credit_blocked())
+    {
+        this_thread::sleep_for(chrono::milliseconds(sim->get_flow_settings().probe_interval_ms));
+        ok = send_with_retries(sim, mutex, PROBE_BYTE);
+    }
+    stats.credit_wait_ns += latency_now_ns() - start_ns;
+    return ok;
+}
+
+// ABORT_BYTE nach einem Fehler mitten in einer Nachricht (siehe protocol.h).
+// false, wenn auch das scheitert; dann vor dem nächsten Byte erneut.
+static bool send_abort(B15Simulator *sim, pthread_mutex_t *mutex)
+{
+    LOG_WARN("[" << sim->name << " TX] Sende ABORT, Empfaenger verwirft angefangene Nachrichten");
+    return send_with_retries(sim, mutex, ABORT_BYTE);
+}
 
-        // Sende Nachricht Byte für Byte (mit Mutex-Schutz)
-        for (size_t i = 0; i < message.length(); ++i)
+// Sende EOT und verbuche die Nachricht
+static bool finish_fullduplex_message(B15Simulator *sim, pthread_mutex_t *mutex, uint64_t message_start_ns)
+{
+    if (!send_with_retries(sim, mutex, EOT_BYTE))
+    {
+        return false;
+    }
+    sim->get_stats().message.record(latency_now_ns() - message_start_ns);
+    LOG_INFO("[" << sim->name << " TX] >>> Nachricht gesendet! <<<\n");
+    return true;
+}
+
+void *fullduplex_tx_thread(void *arg)
+{
+    FullDuplexThreadData *data = (FullDuplexThreadData *)arg;
+    B15Simulator *sim = data->sim;
+    pthread_mutex_t *mutex = data->cable_mutex;
+
+    trace_thread_name(sim->name + " TX");
+    cout << "\n[" << sim->name << " TX] SENDEMODUS (Full-Duplex)" << endl;
+    cout << "[" << sim->name << " TX] Gib Nachrichten ein, eine pro Zeile (Ctrl+C zum Beenden):" << endl;
+
+    // Ein eigener Thread liest stdin in einen lock-freien Ring (siehe
+    // input_stream.h), der TX-Thread holt blockweise ab und hängt nie in
+    // getline(). Jede Zeile ist eine Nachricht, '\n' selbst wird nicht
+    // gesendet, leere Zeilen entfallen.
+    InputStream input;
+    Stats &stats = sim->get_stats();
+    uint8_t block[4096];
+    size_t message_bytes = 0;
+    uint64_t message_start_ns = 0;
+    bool failed = false;        // Rest der Zeile verwerfen, kein EOT
+    bool abort_pending = false; // ABORT_BYTE muss vor dem nächsten Byte raus
+
+    size_t n;
+    while (*(data->running) && (n = input.read(block, sizeof(block))) > 0)
+    {
+        for (size_t i = 0; i < n; ++i)
         {
-            uint8_t byte = message[i];
-            bool success = false;
+            stats.tx_queue_bytes = input.buffered() + (n - i);
 
-            for (int retry = 0; retry < MAX_RETRIES && !success; ++retry)
+            if (block[i] == '\n')
             {
-                if (retry > 0)
+                if (message_bytes > 0 && !failed && !finish_fullduplex_message(sim, mutex, message_start_ns))
                 {
-                    cout << "[" << sim->name << " TX] Retry " << retry << " fuer Byte '" << (char)byte << "'" << endl;
+                    abort_pending = !send_abort(sim, mutex);
                 }
-
-                pthread_mutex_lock(mutex);
-                success = sim->send_byte_with_checksum(byte);
-                pthread_mutex_unlock(mutex);
-
-                if (!success)
+                message_bytes = 0;
+                failed = false;
+                continue;
+            }
+            if (failed)
+            {
+                continue;
+            }
+            if (abort_pending)
+            {
+                abort_pending = !send_abort(sim, mutex);
+                if (abort_pending)
                 {
-                    this_thread::sleep_for(chrono::milliseconds(10));
+                    failed = true;
+                    continue;
                 }
             }
 
+            if (message_bytes++ == 0)
+            {
+                message_start_ns = latency_now_ns();
+            }
+
+            // Sende Byte (mit Mutex-Schutz), maskierte Bytes als ESC + Byte
+            uint8_t wire[2];
+            int wire_bytes = stuff_byte(block[i], wire);
+
+            bool success = wait_for_credit(sim, mutex) && send_with_retries(sim, mutex, wire[0]);
+            if (success && wire_bytes == 2)
+            {
+                success = send_with_retries(sim, mutex, wire[1]);
+            }
+
             if (!success)
             {
-                cerr << "[" << sim->name << " TX] Uebertragung fehlgeschlagen!" << endl;
-                break;
+                LOG_ERROR("[" << sim->name << " TX] Uebertragung fehlgeschlagen!");
+                failed = true;
+                abort_pending = !send_abort(sim, mutex);
             }
         }
+    }
+
+    if (message_bytes > 0 && !failed && !finish_fullduplex_message(sim, mutex, message_start_ns))
+    {
+        send_abort(sim, mutex);
+    }
+    stats.tx_queue_bytes = 0;
 
-        // Sende EOT
-        bool eot_sent = false;
-        for (int retry = 0; retry < MAX_RETRIES && !eot_sent; ++retry)
+    return nullptr;
+}
+
+// Daemon-Modus: Nachrichten der Clients statt stdin, jede mit Bestätigung
+void *daemon_tx_thread(void *arg)
+{
+    FullDuplexThreadData *data = (FullDuplexThreadData *)arg;
+    B15Simulator *sim = data->sim;
+    pthread_mutex_t *mutex = data->cable_mutex;
+    LinkDaemon *daemon = data->daemon;
+
+    trace_thread_name(sim->name + " TX");
+    Stats &stats = sim->get_stats();
+    OutgoingFrame frame;
+    int tx_channel = 0; // Stand des Empfängers, -1 = unbekannt
+    uint64_t start_ns[MAX_CHANNELS] = {};
+    bool abort_pending = false; // ABORT_BYTE muss vor dem nächsten Frame raus
+
+    while (*(data->running) && daemon->running())
+    {
+        if (!daemon->next_frame(frame, 100))
         {
-            pthread_mutex_lock(mutex);
-            eot_sent = sim->send_byte_with_checksum(EOT_BYTE);
-            pthread_mutex_unlock(mutex);
+            continue;
+        }
+        stats.tx_queue_bytes = daemon->queued_bytes() + frame.data.size();
+        if (frame.first)
+        {
+            start_ns[frame.channel] = latency_now_ns();
+        }
 
-            if (!eot_sent)
+        // Kanal nur bei Wechsel umschalten, sonst läuft alles wie bisher
+        bool success = true;
+        if (abort_pending)
+        {
+            abort_pending = !send_abort(sim, mutex);
+            success = !abort_pending;
+        }
+        if (success && frame.channel != tx_channel)
+        {
+            uint8_t wire[3];
+            int wire_bytes = channel_switch(frame.channel, wire);
+            for (int i = 0; i < wire_bytes && success; ++i)
             {
-                this_thread::sleep_for(chrono::milliseconds(10));
+                success = send_with_retries(sim, mutex, wire[i]);
             }
+            tx_channel = frame.channel;
         }
 
-        if (eot_sent)
+        for (size_t i = 0; i < frame.data.size() && success; ++i)
         {
-            cout << "[" << sim->name << " TX] >>> Nachricht gesendet! <<<\n"
-                 << endl;
+            uint8_t wire[2];
+            int wire_bytes = stuff_byte(frame.data[i], wire);
+
+            success = wait_for_credit(sim, mutex) && send_with_retries(sim, mutex, wire[0]);
+            if (success && wire_bytes == 2)
+            {
+                success = send_with_retries(sim, mutex, wire[1]);
+            }
         }
+
+        if (success && frame.last)
+        {
+            success = finish_fullduplex_message(sim, mutex, start_ns[frame.channel]);
+        }
+
+        // Nach einem Fehler ABORT statt EOT: der Empfänger verwirft alle
+        // Teilnachrichten, hier scheitern deshalb auch die angefangenen
+        // Nachrichten der anderen Kanäle. Danach steht er auf Kanal 0.
+        if (!success)
+        {
+            LOG_ERROR("[" << sim->name << " TX] Uebertragung fehlgeschlagen!");
+            if (!abort_pending)
+            {
+                abort_pending = !send_abort(sim, mutex);
+            }
+            tx_channel = abort_pending ? -1 : 0;
+        }
+        daemon->sent(frame, success);
+        if (!success)
+        {
+            daemon->abort_started();
+        }
+        stats.tx_queue_bytes = daemon->queued_bytes();
     }
 
     return nullptr;
@@ -441,21 +1144,41 @@ void *fullduplex_rx_thread(void *arg)
     B15Simulator *sim = data->sim;
     pthread_mutex_t *mutex = data->cable_mutex;
 
-    // Open output file for this board
-    string filename = "received_" + sim->name.substr(sim->name.find(' ') + 1) + ".txt";
-    ofstream outfile(filename, ios::app); // Append mode
+    trace_thread_name(sim->name + " RX");
+
+    // Open output file for this board (Append, gesammelt geschrieben);
+    // im Daemon-Modus gehen die Nachrichten an die Abonnenten
+    string filename = "received_" + board_letter(sim->name) + ".txt";
+    GroupCommitWriter outfile(sim->get_writer_settings());
+    outfile.set_stats(&sim->get_stats());
+    if (!data->daemon)
+    {
+        string error;
+        if (!outfile.open(filename, error))
+        {
+            LOG_WARN("[" << sim->name << " RX] " << error);
+        }
+        else
+        {
+            // Kommt die Platte nicht hinterher, bremsen die Credits den Sender
+            sim->set_rx_consumer(&outfile);
+        }
 
-    cout << "[" << sim->name << " RX] EMPFANGSMODUS (Full-Duplex)" << endl;
-    cout << "[" << sim->name << " RX] Schreibe empfangene Nachrichten in: " << filename << endl;
-    cout << "[" << sim->name << " RX] Warte auf Nachrichten..." << endl;
+        cout << "[" << sim->name << " RX] EMPFANGSMODUS (Full-Duplex)" << endl;
+        cout << "[" << sim->name << " RX] Schreibe empfangene Nachrichten in: " << filename << endl;
+        cout << "[" << sim->name << " RX] Warte auf Nachrichten..." << endl;
+    }
 
-    string received_message = "";
+    ChannelArenas received(sim->get_spill_settings(), board_letter(sim->name)); // Pro Kanal, zu große Nachrichten als Spill-Datei
+    uint64_t start_ns[MAX_CHANNELS] = {};
+    Unstuffer unstuffer;
+    ChannelTracker channels;
 
     while (*(data->running))
     {
-        pthread_mutex_lock(mutex);
+        lock_cable(mutex);
         uint8_t byte = sim->receive_byte_with_checksum();
-        pthread_mutex_unlock(mutex);
+        unlock_cable(mutex);
 
         if (byte == 0xFF)
         {
@@ -464,35 +1187,65 @@ void *fullduplex_rx_thread(void *arg)
             continue;
         }
 
-        if (byte == EOT_BYTE)
+        Unstuffer::Kind kind = unstuffer.feed(byte);
+        if (kind == Unstuffer::PENDING || !channels.feed(kind, byte))
+        {
+            continue;
+        }
+
+        if (kind == Unstuffer::CONTROL && byte == ABORT_BYTE)
+        {
+            LOG_WARN("[" << sim->name << " RX] ABORT empfangen, angefangene Nachrichten verworfen");
+            received.reset();
+            for (int i = 0; i < MAX_CHANNELS; i++)
+            {
+                start_ns[i] = 0;
+            }
+            continue;
+        }
+
+        // Nachrichten verschiedener Kanäle können sich abwechseln
+        int channel = channels.current();
+        MessageArena &received_message = received[channel];
+        uint64_t &message_start_ns = start_ns[channel];
+        if (message_start_ns == 0)
         {
-            cout << "[" << sim->name << " RX] >>> NACHRICHT EMPFANGEN: \""
-                 << received_message << "\" <<<" << endl;
+            message_start_ns = latency_now_ns();
+        }
+
+        if (kind == Unstuffer::CONTROL && byte == EOT_BYTE)
+        {
+            // Zu große Nachrichten liegen in einer Spill-Datei, dann nur der Verweis
+            string note;
+            ByteSpan message = received_message.take_message(note);
+            LOG_INFO("[" << sim->name << " RX] >>> NACHRICHT EMPFANGEN: \"" << message << "\" <<<");
 
             // Write to file
-            if (outfile.is_open())
+            if (data->daemon)
             {
-                outfile << received_message << endl;
-                outfile.flush();
+                data->daemon->deliver(channel, message);
+            }
+            else if (outfile.is_open())
+            {
+                outfile.append(message);
             }
 
-            received_message = "";
+            sim->get_stats().message.record(latency_now_ns() - message_start_ns);
+            received_message.reset();
+            message_start_ns = 0;
             continue;
         }
 
-        received_message += (char)byte;
-    }
-
-    if (outfile.is_open())
-    {
-        outfile.close();
+        received_message.push(byte);
     }
 
+    sim->set_rx_consumer(nullptr);
     return nullptr;
 }
 
 void B15Simulator::run_fullduplex_mode()
 {
+    AsyncLogger::instance().flush();
     cout << "\n========================================" << endl;
     cout << "  FULL-DUPLEX MODE - " << name << endl;
     cout << "========================================" << endl;
@@ -512,8 +1265,8 @@ void B15Simulator::run_fullduplex_mode()
 
     pthread_t tx_thread, rx_thread;
 
-    FullDuplexThreadData tx_data = {this, &running, &cable_mutex};
-    FullDuplexThreadData rx_data = {this, &running, &cable_mutex};
+    FullDuplexThreadData tx_data = {this, &running, &cable_mutex, nullptr};
+    FullDuplexThreadData rx_data = {this, &running, &cable_mutex, nullptr};
 
     // Starte TX Thread (Sender)
     pthread_create(&tx_thread, nullptr, fullduplex_tx_thread, &tx_data);
@@ -529,6 +1282,36 @@ void B15Simulator::run_fullduplex_mode()
 
     pthread_mutex_destroy(&cable_mutex);
 
+    AsyncLogger::instance().flush();
     cout << "\n[" << name << "] Full-Duplex Mode beendet." << endl;
-    global_stats.print();
+    stats->print();
+}
+
+void B15Simulator::run_daemon_mode(LinkDaemon &daemon)
+{
+    AsyncLogger::instance().flush();
+    cout << "\n[" << name << "] DAEMON-MODUS: Link laeuft, Clients ueber den Socket" << endl;
+
+    // Wie Full-Duplex, nur mit den Clients als Quelle und Ziel
+    volatile bool running = true;
+    pthread_mutex_t cable_mutex;
+    pthread_mutex_init(&cable_mutex, nullptr);
+
+    pthread_t tx_thread, rx_thread;
+    FullDuplexThreadData tx_data = {this, &running, &cable_mutex, &daemon};
+    FullDuplexThreadData rx_data = {this, &running, &cable_mutex, &daemon};
+
+    pthread_create(&tx_thread, nullptr, daemon_tx_thread, &tx_data);
+    pthread_create(&rx_thread, nullptr, fullduplex_rx_thread, &rx_data);
+
+    pthread_join(tx_thread, nullptr);
+
+    running = false;
+    pthread_join(rx_thread, nullptr);
+
+    pthread_mutex_destroy(&cable_mutex);
+
+    AsyncLogger::instance().flush();
+    cout << "\n[" << name << "] Daemon beendet." << endl;
+    stats->print();
 }
@@ -2,6 +2,13 @@
 #define B15SIMULATOR_H
 
 #include "patch_cable.h"
+#include "fault_scenario.h"
+#include "protocol.h"
+#include "stats.h"
+#include "error_injector.h"
+#include "group_writer.h"
+#include "link_daemon.h"
+#include <memory>
 #include <string>
 #include <cstdint>
 
@@ -12,38 +19,87 @@ public:
 
 private:
     bool is_board_a;
-    PatchCableFile cable;
+    std::unique_ptr<PatchCable> own_cable; // Nur gesetzt, wenn kein Kabel übergeben wurde
+    PatchCable *cable;
     bool verbose;
-
-    // Bit-Masken
-    static const uint8_t DATA0 = 0x01;
-    static const uint8_t DATA1 = 0x02;
-    static const uint8_t CLOCK = 0x04;
-    static const uint8_t ACK = 0x08;
+    FaultScenario *scenario;
+    ProtocolSettings settings;
+    WriterSettings writer_settings;
+    SpillSettings spill_settings;
+    FlowSettings flow_settings;
+    Stats *stats;
+    ErrorInjector *injector;
 
     uint8_t current_clock_state;
     uint8_t last_received_ack;
     uint8_t last_received_clock;
     uint8_t current_ack_state;
 
+    BacklogSource *rx_consumer; // Bestimmt den Credit in unseren ACKs
+    long tx_credit;             // Platz bei der Gegenseite laut letztem ACK, -1 = unbegrenzt
+    bool tx_channel_id;         // Nächstes gesendetes Byte ist eine Kanalnummer (Statistik)
+    bool rx_channel_id;         // dito, empfangen
+
     // Private Methoden
+    void init();
+    void update_scenario();
     void write_output(uint8_t data);
     uint8_t read_input();
+    void poll_sleep();
+    void record_polls(int polls, bool completed);
+    uint8_t ack_byte();
 
     bool send_2bits(uint8_t data);
     uint8_t receive_2bits();
     bool send_byte_raw(uint8_t byte);
-    uint8_t receive_byte_raw();
+    bool receive_byte_raw(uint8_t &byte, uint64_t *first_symbol_ns = nullptr); // false = Timeout
+    bool send_payload_byte(uint8_t byte); // Mit Byte-Stuffing
+    bool send_block(const uint8_t *data, size_t len);
+    bool finish_message(size_t message_bytes, uint64_t message_start_ns);
+    bool send_abort(); // ABORT_BYTE nach einem Fehler mitten in einer Nachricht
 
 public:
     B15Simulator(bool is_a, bool verb = false);
+    // Für mehrere Links in einem Prozess (z.B. mit PatchCableMemory)
+    B15Simulator(bool is_a, PatchCable &shared_cable, bool verb = false);
+
+    void set_protocol_settings(const ProtocolSettings &s);
+    // Ausgabe der Full-Duplex-Empfänger (received_X.txt)
+    void set_writer_settings(const WriterSettings &s);
+    const WriterSettings &get_writer_settings() const;
+    // Ab welcher Größe empfangene Nachrichten in eine Datei ausgelagert werden
+    void set_spill_settings(const SpillSettings &s);
+    const SpillSettings &get_spill_settings() const;
+    // Empfangsfenster und Nachfrage-Intervall der Credit-Flusskontrolle
+    void set_flow_settings(const FlowSettings &s);
+    const FlowSettings &get_flow_settings() const;
+    // Verbraucher des Empfangs (Datei, Pipe), nullptr = ACK ohne Credit
+    void set_rx_consumer(BacklogSource *consumer);
+    void set_stats(Stats *s);                  // Default: global_stats
+    void set_error_injector(ErrorInjector *e); // Default: error_injector
+    Stats &get_stats();
 
     bool send_byte_with_checksum(uint8_t byte);
     uint8_t receive_byte_with_checksum();
 
+    // Gegenseite meldet vollen Puffer; vor dem nächsten Nutzdaten-Byte warten
+    bool credit_blocked() const { return tx_credit == 0; }
+    // Fragt mit PROBE_BYTE nach, bis wieder Credit da ist; false bei Leitungsfehler
+    bool wait_for_credit();
+
+    // Leitungsfehler auf den Leitungen, die dieses Board liest
+    WireFaultModel &incoming_wire_faults();
+
+    // Optionaler Fehler-Ablauf, wird vor jedem Byte aktualisiert
+    void set_fault_scenario(FaultScenario *s);
+
     void run_sender_mode();
+    void run_send_file_mode(const std::string &path); // Datei per mmap, eine Nachricht
     void run_receiver_mode();
+    void run_raw_receiver_mode(); // Nur Nutzdaten auf stdout, endet wenn stdout zu ist
     void run_fullduplex_mode();
+    // Link für lokale Clients über daemon (siehe link_daemon.h), läuft bis daemon stoppt
+    void run_daemon_mode(LinkDaemon &daemon);
 };
 
 #endif // B15SIMULATOR_H
@@ -7,7 +7,10 @@ param(
 $CXX = "g++"
 $CXXFLAGS = "-std=c++11 -pthread -Wall"
 $TARGET = "simulator.exe"
-$SOURCES = @("main.cpp", "checksum.cpp", "stats.cpp", "error_injector.cpp", "patch_cable.cpp", "b15simulator.cpp")
+$SWEEP_TARGET = "sweep.exe"
+$TRACETOOL_TARGET = "tracetool.exe"
+$SELFTEST_TARGET = "selftest.exe"
+$SOURCES = @("main.cpp", "checksum.cpp", "histogram.cpp", "stats.cpp", "stats_export.cpp", "dashboard.cpp", "error_injector.cpp", "wire_faults.cpp", "fault_scenario.cpp", "patch_cable.cpp", "trace.cpp", "perf_counters.cpp", "input_stream.cpp", "mapped_file.cpp", "message_arena.cpp", "raw_output.cpp", "group_writer.cpp", "link_daemon.cpp", "b15simulator.cpp")
 
 function Build {
     Write-Host "Building $TARGET..." -ForegroundColor Green
@@ -23,10 +26,67 @@ function Build {
     }
 }
 
+function Build-Sweep {
+    Write-Host "Building $SWEEP_TARGET..." -ForegroundColor Green
+    $sourceFiles = (@("sweep.cpp") + ($SOURCES | Where-Object { $_ -ne "main.cpp" })) -join " "
+    $cmd = "$CXX $CXXFLAGS $sourceFiles -o $SWEEP_TARGET"
+    Write-Host $cmd -ForegroundColor Yellow
+    Invoke-Expression $cmd
+    if ($LASTEXITCODE -eq 0) {
+        Write-Host "Build successful!" -ForegroundColor Green
+    } else {
+        Write-Host "Build failed!" -ForegroundColor Red
+        exit 1
+    }
+}
+
+function Build-TraceTool {
+    Write-Host "Building $TRACETOOL_TARGET..." -ForegroundColor Green
+    $cmd = "$CXX $CXXFLAGS tracetool.cpp trace.cpp -o $TRACETOOL_TARGET"
+    Write-Host $cmd -ForegroundColor Yellow
+    Invoke-Expression $cmd
+    if ($LASTEXITCODE -eq 0) {
+        Write-Host "Build successful!" -ForegroundColor Green
+    } else {
+        Write-Host "Build failed!" -ForegroundColor Red
+        exit 1
+    }
+}
+
+function Run-SelfTest {
+    Write-Host "Building $SELFTEST_TARGET..." -ForegroundColor Green
+    $sourceFiles = (@("selftest.cpp") + ($SOURCES | Where-Object { $_ -ne "main.cpp" })) -join " "
+    $cmd = "$CXX $CXXFLAGS $sourceFiles -o $SELFTEST_TARGET"
+    Write-Host $cmd -ForegroundColor Yellow
+    Invoke-Expression $cmd
+    if ($LASTEXITCODE -ne 0) {
+        Write-Host "Build failed!" -ForegroundColor Red
+        exit 1
+    }
+    & ".\$SELFTEST_TARGET"
+    if ($LASTEXITCODE -ne 0) {
+        Write-Host "Selftest failed!" -ForegroundColor Red
+        exit 1
+    }
+}
+
+function Run-Sweep {
+    if (!(Test-Path $SWEEP_TARGET)) {
+        Write-Host "Sweep executable not found. Building first..." -ForegroundColor Yellow
+        Build-Sweep
+    }
+    Write-Host "Running Monte-Carlo sweep..." -ForegroundColor Cyan
+    & ".\$SWEEP_TARGET" --rates=0,1,5,10,20 --faults=none,glitch:clock:0.001,delay:ack:3 --out=sweep.csv
+}
+
 function Clean {
     Write-Host "Cleaning build artifacts..." -ForegroundColor Green
     Remove-Item *.o -ErrorAction SilentlyContinue
     Remove-Item $TARGET -ErrorAction SilentlyContinue
+    Remove-Item $SWEEP_TARGET -ErrorAction SilentlyContinue
+    Remove-Item $TRACETOOL_TARGET -ErrorAction SilentlyContinue
+    Remove-Item $SELFTEST_TARGET -ErrorAction SilentlyContinue
+    Remove-Item trace_*.bin -ErrorAction SilentlyContinue
     Remove-Item patchcable.bin -ErrorAction SilentlyContinue
     Write-Host "Cleaned!" -ForegroundColor Green
 }
@@ -86,6 +146,10 @@ Commands:
     run-receiver        Run Board B in receiver mode (half-duplex, 20% error)
     run-fullduplex-a    Run Board A in full-duplex mode
     run-fullduplex-b    Run Board B in full-duplex mode (20% error)
+    sweep               Build the Monte-Carlo sweep harness
+    run-sweep           Run the sweep and write sweep.csv
+    tracetool           Build the trace dump decoder
+    test                Build and run the self-test
     help                Show this help message
 
 Examples:
@@ -113,6 +177,10 @@ switch ($Command.ToLower()) {
     "run-receiver" { Run-Receiver }
     "run-fullduplex-a" { Run-Fullduplex-A }
     "run-fullduplex-b" { Run-Fullduplex-B }
+    "sweep" { Build-Sweep }
+    "run-sweep" { Run-Sweep }
+    "tracetool" { Build-TraceTool }
+    "test" { Run-SelfTest }
     "help" { Show-Help }
     default {
         Write-Host "Unknown command: $Command" -ForegroundColor Red
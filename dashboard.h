@@ -0,0 +1,54 @@
+#ifndef DASHBOARD_H
+#define DASHBOARD_H
+
+#include "stats.h"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Live-Statuszeile für laufende Links, z.B.
+//   [A] 412.3 B/s | 3310 Sym/s | Retx 1.2/s (0.3%) | Fehler 0.0% | Queue 37 B | ETA 00:41
+// Wird mehrmals pro Sekunde auf stderr mit \r überschrieben, stdout bleibt
+// also frei. Liest nur Stats::snapshot() und Histogramm-Zähler, die
+// Protokoll-Threads werden nie blockiert.
+class Dashboard
+{
+public:
+    Dashboard(const Stats &s, const std::string &board);
+    ~Dashboard(); // Stoppt den Thread und schließt die Zeile ab
+
+    // Gesamtgröße der Übertragung in Bytes (z.B. Größe der Eingabedatei)
+    // für die ETA; 0 = unbekannt
+    void set_total_bytes(uint64_t total);
+
+    void start(int interval_ms);
+    void stop();
+
+private:
+    const Stats &stats;
+    std::string board_name;
+    uint64_t total_bytes;
+
+    std::thread worker;
+    std::mutex mtx;
+    std::condition_variable wakeup;
+    bool stopping;
+    int interval_ms;
+
+    uint64_t last_ns;
+    StatsSnapshot last;
+    uint64_t last_symbols;
+
+    // Geglättete Raten, damit die Anzeige nicht bei jedem Refresh springt
+    double payload_rate;
+    double tx_payload_rate; // Nur gesendete Nutzdaten, für die ETA
+    double symbol_rate;
+    double retx_rate;
+
+    void run();
+    void refresh();
+};
+
+#endif // DASHBOARD_H
@@ -1,33 +1,98 @@
 #include "error_injector.h"
-#include <iostream>
+#include "logger.h"
 #include <bitset>
-#include <cstdlib>
 #include <ctime>
+#include <limits>
 
 using namespace std;
 
 ErrorInjector error_injector(0);
 
-ErrorInjector::ErrorInjector(int rate) : error_rate_percent(rate)
+ErrorInjector::ErrorInjector(double rate)
+    : error_probability(rate / 100.0), rng(time(NULL))
 {
-    srand(time(NULL));
+    draw_next_gap();
 }
 
-void ErrorInjector::set_error_rate(int rate)
+void ErrorInjector::set_error_rate(double rate)
 {
-    error_rate_percent = rate;
-    cout << "[ERROR-INJECTOR] Fehlerrate gesetzt auf " << rate << "%" << endl;
+    error_probability = rate / 100.0;
+    draw_next_gap();
+    LOG_INFO("[ERROR-INJECTOR] Fehlerrate gesetzt auf " << rate << "%");
+}
+
+void ErrorInjector::set_seed(uint64_t seed)
+{
+    rng.seed(seed);
+    draw_next_gap();
+}
+
+void ErrorInjector::draw_next_gap()
+{
+    if (error_probability <= 0.0)
+    {
+        bytes_until_error = numeric_limits<uint64_t>::max();
+        return;
+    }
+    if (error_probability >= 1.0)
+    {
+        bytes_until_error = 0;
+        return;
+    }
+
+    // Anzahl fehlerfreier Bytes vor dem nächsten Fehler
+    geometric_distribution<uint64_t> gap(error_probability);
+    bytes_until_error = gap(rng);
+}
+
+uint8_t ErrorInjector::flip_random_bit(uint8_t data, int &bit_to_flip)
+{
+    bit_to_flip = rng() & 0x07;
+    draw_next_gap();
+    return data ^ (1 << bit_to_flip);
 }
 
 uint8_t ErrorInjector::inject_error(uint8_t data)
 {
-    if (error_rate_percent > 0 && (rand() % 100) < error_rate_percent)
+    if (error_probability <= 0.0)
     {
-        int bit_to_flip = rand() % 8;
-        uint8_t corrupted = data ^ (1 << bit_to_flip);
-        cout << "  [ERROR!] Bit " << bit_to_flip << " geflippt: "
-             << bitset<8>(data) << " -> " << bitset<8>(corrupted) << endl;
-        return corrupted;
+        return data;
     }
-    return data;
+
+    if (bytes_until_error > 0)
+    {
+        bytes_until_error--;
+        return data;
+    }
+
+    int bit_to_flip;
+    uint8_t corrupted = flip_random_bit(data, bit_to_flip);
+    LOG_DEBUG("  [ERROR!] Bit " << bit_to_flip << " geflippt: "
+                                << bitset<8>(data) << " -> " << bitset<8>(corrupted));
+    return corrupted;
+}
+
+size_t ErrorInjector::inject_errors(uint8_t *data, size_t len)
+{
+    if (error_probability <= 0.0)
+    {
+        return 0;
+    }
+
+    size_t pos = 0;
+    size_t corrupted = 0;
+    int bit_to_flip;
+
+    // Von Fehler zu Fehler springen, Bytes dazwischen bleiben unberührt
+    while (bytes_until_error < len - pos)
+    {
+        pos += bytes_until_error;
+        data[pos] = flip_random_bit(data[pos], bit_to_flip);
+        pos++;
+        corrupted++;
+    }
+
+    // Restlichen Abstand in den nächsten Aufruf mitnehmen
+    bytes_until_error -= (len - pos);
+    return corrupted;
 }
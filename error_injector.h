@@ -1,18 +1,36 @@
 #ifndef ERROR_INJECTOR_H
 #define ERROR_INJECTOR_H
 
+#include <cstddef>
 #include <cstdint>
+#include <random>
 
-// Simulierte Fehler-Injektion
+// Simulierte Fehler-Injektion. Ausgaben gehen über den Logger: die neue
+// Rate als LOG_INFO, jeder Bitflip als LOG_DEBUG.
+// Statt pro Byte zu würfeln wird der Abstand bis zum nächsten Fehler
+// geometrisch gezogen, fehlerfreie Bytes kosten also keinen Zufallswert.
 class ErrorInjector
 {
 private:
-    int error_rate_percent; // 0-100
+    double error_probability; // 0.0-1.0 pro Byte
+    std::mt19937_64 rng;
+    uint64_t bytes_until_error; // Fehlerfreie Bytes bis zum nächsten Fehler
+
+    void draw_next_gap();
+    uint8_t flip_random_bit(uint8_t data, int &bit_to_flip);
 
 public:
-    ErrorInjector(int rate = 0);
-    void set_error_rate(int rate);
+    ErrorInjector(double rate = 0);
+    void set_error_rate(double rate); // Prozent, 0-100 (auch 0.1 etc.)
+    void set_seed(uint64_t seed);     // Reproduzierbare Fehlerfolgen
+
     uint8_t inject_error(uint8_t data);
+
+    // Bulk-Variante für ganze Puffer/Frames: fasst nur die Bytes an, die
+    // tatsächlich verfälscht werden. Der Abstand zum nächsten Fehler läuft
+    // über Aufrufe (auch gemischt mit inject_error()) weiter. Rückgabe =
+    // Anzahl verfälschter Bytes.
+    size_t inject_errors(uint8_t *data, size_t len);
 };
 
 extern ErrorInjector error_injector;
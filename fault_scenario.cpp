@@ -0,0 +1,211 @@
+#include "fault_scenario.h"
+#include "logger.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+static bool parse_trigger(const string &text, uint64_t &threshold, bool &is_time)
+{
+    char *end = nullptr;
+    double value = strtod(text.c_str(), &end);
+    string unit(end);
+
+    if (end == text.c_str() || value < 0)
+        return false;
+
+    if (unit == "s")
+    {
+        is_time = true;
+        threshold = (uint64_t)(value * 1000000.0);
+    }
+    else if (unit == "ms")
+    {
+        is_time = true;
+        threshold = (uint64_t)(value * 1000.0);
+    }
+    else if (unit == "B")
+    {
+        is_time = false;
+        threshold = (uint64_t)value;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+bool FaultScenario::load(const string &filename, string &error)
+{
+    ifstream file(filename);
+    if (!file.is_open())
+    {
+        error = "Szenario-Datei nicht gefunden: " + filename;
+        return false;
+    }
+
+    time_steps.clear();
+    byte_steps.clear();
+
+    string line;
+    int line_no = 0;
+    while (getline(file, line))
+    {
+        line_no++;
+
+        size_t comment = line.find('#');
+        if (comment != string::npos)
+            line = line.substr(0, comment);
+
+        stringstream ss(line);
+        string trigger, action, argument, extra;
+        if (!(ss >> trigger))
+            continue;
+        ss >> action >> argument;
+        if (ss >> extra)
+        {
+            error = "Zeile " + to_string(line_no) + ": unerwartetes '" + extra + "' am Zeilenende";
+            return false;
+        }
+
+        Step step;
+        bool is_time = true;
+        step.value = 0;
+        step.seed = 0;
+        step.text = action + (argument.empty() ? "" : " " + argument);
+        step.order = time_steps.size() + byte_steps.size();
+
+        if (!parse_trigger(trigger, step.threshold, is_time))
+        {
+            error = "Zeile " + to_string(line_no) + ": ungueltiger Trigger '" + trigger + "'";
+            return false;
+        }
+        step.trigger = is_time ? TRIGGER_TIME : TRIGGER_BYTES;
+
+        bool valid = true;
+        if (action == "clean")
+        {
+            step.action = ACTION_CLEAN;
+            valid = argument.empty();
+        }
+        else if (action == "clear_faults")
+        {
+            step.action = ACTION_CLEAR_FAULTS;
+            valid = argument.empty();
+        }
+        else if (action == "error_rate")
+        {
+            step.action = ACTION_ERROR_RATE;
+            step.value = atof(argument.c_str());
+            valid = !argument.empty() && step.value >= 0 && step.value <= 100;
+        }
+        else if (action == "seed")
+        {
+            step.action = ACTION_SEED;
+            step.seed = strtoull(argument.c_str(), nullptr, 10);
+            valid = !argument.empty();
+        }
+        else if (action == "fault")
+        {
+            step.action = ACTION_FAULT;
+            valid = parse_wire_fault(argument, step.fault);
+        }
+        else
+        {
+            valid = false;
+        }
+
+        if (!valid)
+        {
+            error = "Zeile " + to_string(line_no) + ": ungueltige Aktion '" + step.text + "'";
+            return false;
+        }
+
+        if (is_time)
+            time_steps.push_back(step);
+        else
+            byte_steps.push_back(step);
+    }
+
+    // Stabil sortieren: gleiche Trigger behalten die Reihenfolge der Datei
+    stable_sort(time_steps.begin(), time_steps.end(), [](const Step &a, const Step &b)
+                { return a.threshold < b.threshold; });
+    stable_sort(byte_steps.begin(), byte_steps.end(), [](const Step &a, const Step &b)
+                { return a.threshold < b.threshold; });
+
+    start();
+    return true;
+}
+
+bool FaultScenario::empty() const
+{
+    return time_steps.empty() && byte_steps.empty();
+}
+
+void FaultScenario::start()
+{
+    next_time_step = 0;
+    next_byte_step = 0;
+    start_time = chrono::steady_clock::now();
+}
+
+void FaultScenario::update(uint64_t bytes_transferred, ErrorInjector &injector, WireFaultModel &wires)
+{
+    if (next_time_step == time_steps.size() && next_byte_step == byte_steps.size())
+        return;
+
+    uint64_t elapsed_us = chrono::duration_cast<chrono::microseconds>(
+                              chrono::steady_clock::now() - start_time)
+                              .count();
+
+    // Fällige Schritte beider Listen in Datei-Reihenfolge anwenden
+    vector<const Step *> due;
+    while (next_time_step < time_steps.size() &&
+           time_steps[next_time_step].threshold <= elapsed_us)
+    {
+        due.push_back(&time_steps[next_time_step++]);
+    }
+    while (next_byte_step < byte_steps.size() &&
+           byte_steps[next_byte_step].threshold <= bytes_transferred)
+    {
+        due.push_back(&byte_steps[next_byte_step++]);
+    }
+
+    stable_sort(due.begin(), due.end(), [](const Step *a, const Step *b)
+                { return a->order < b->order; });
+    for (size_t i = 0; i < due.size(); i++)
+    {
+        apply(*due[i], elapsed_us, bytes_transferred, injector, wires);
+    }
+}
+
+void FaultScenario::apply(const Step &step, uint64_t elapsed_us, uint64_t bytes,
+                          ErrorInjector &injector, WireFaultModel &wires)
+{
+    LOG_INFO("[SCENARIO] t=" << (elapsed_us / 1000000.0) << "s bytes=" << bytes
+                             << ": " << step.text);
+
+    switch (step.action)
+    {
+    case ACTION_CLEAN:
+        injector.set_error_rate(0);
+        wires.clear();
+        break;
+    case ACTION_ERROR_RATE:
+        injector.set_error_rate(step.value);
+        break;
+    case ACTION_FAULT:
+        wires.add(step.fault);
+        break;
+    case ACTION_CLEAR_FAULTS:
+        wires.clear();
+        break;
+    case ACTION_SEED:
+        injector.set_seed(step.seed);
+        wires.set_seed(step.seed);
+        break;
+    }
+}
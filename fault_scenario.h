@@ -0,0 +1,81 @@
+#ifndef FAULT_SCENARIO_H
+#define FAULT_SCENARIO_H
+
+#include "error_injector.h"
+#include "wire_faults.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Zeit- bzw. bytegesteuerter Ablauf von Fehlermodellen.
+//
+// Dateiformat (eine Anweisung pro Zeile, '#' leitet Kommentare ein):
+//   <trigger> <aktion> [argument]
+//
+//   trigger: 10s, 250ms   -> Zeit seit Start des Szenarios
+//            5000B        -> Anzahl übertragener Bytes (gesendet + empfangen)
+//            Werden mehrere Schritte zugleich fällig, gilt die Reihenfolge
+//            der Datei, egal ob Zeit- oder Byte-Trigger.
+//   aktion:  clean              Fehlerrate 0 und alle Leitungsfehler entfernen
+//            error_rate <pct>   Byte-Fehlerrate setzen
+//            fault <spec>       Leitungsfehler hinzufügen (siehe parse_wire_fault)
+//            clear_faults       Alle Leitungsfehler entfernen
+//            seed <n>           Zufallsgeneratoren neu seeden
+//
+// Beispiel:
+//   0s     seed 42
+//   10s    error_rate 20
+//   12s    clean
+//   12s    fault stuck1:clock
+class FaultScenario
+{
+public:
+    bool load(const std::string &filename, std::string &error);
+    bool empty() const;
+
+    // Startet die Zeitbasis neu
+    void start();
+
+    // Wendet alle fälligen Schritte an
+    void update(uint64_t bytes_transferred, ErrorInjector &injector, WireFaultModel &wires);
+
+private:
+    enum TriggerKind
+    {
+        TRIGGER_TIME,
+        TRIGGER_BYTES
+    };
+
+    enum Action
+    {
+        ACTION_CLEAN,
+        ACTION_ERROR_RATE,
+        ACTION_FAULT,
+        ACTION_CLEAR_FAULTS,
+        ACTION_SEED
+    };
+
+    struct Step
+    {
+        TriggerKind trigger;
+        uint64_t threshold; // Mikrosekunden bzw. Bytes
+        Action action;
+        double value;
+        uint64_t seed;
+        WireFault fault;
+        std::string text;
+        size_t order; // Position in der Datei
+    };
+
+    std::vector<Step> time_steps;
+    std::vector<Step> byte_steps;
+    size_t next_time_step = 0;
+    size_t next_byte_step = 0;
+    std::chrono::steady_clock::time_point start_time;
+
+    void apply(const Step &step, uint64_t elapsed_us, uint64_t bytes,
+               ErrorInjector &injector, WireFaultModel &wires);
+};
+
+#endif // FAULT_SCENARIO_H
@@ -1,3 +1,4 @@
+#include "logger.h"
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -85,8 +86,8 @@ public:
         {
             int bit_to_flip = rand() % 8;
             uint8_t corrupted = data ^ (1 << bit_to_flip);
-            cout << "  [ERROR!] Bit " << bit_to_flip << " geflippt: "
-                 << bitset<8>(data) << " -> " << bitset<8>(corrupted) << endl;
+            LOG_DEBUG("  [ERROR!] Bit " << bit_to_flip << " geflippt: "
+                      << bitset<8>(data) << " -> " << bitset<8>(corrupted));
             return corrupted;
         }
         return data;
@@ -199,7 +200,7 @@ private:
             cable.write_bits_a(data & 0x0F);
             if (verbose)
             {
-                cout << "  [" << name << "] -> " << bitset<4>(data & 0x0F) << endl;
+                LOG_TRACE("  [" << name << "] -> " << bitset<4>(data & 0x0F));
             }
         }
         else
@@ -207,7 +208,7 @@ private:
             cable.write_bits_b(data & 0x0F);
             if (verbose)
             {
-                cout << "  [" << name << "] -> " << bitset<4>(data & 0x0F) << endl;
+                LOG_TRACE("  [" << name << "] -> " << bitset<4>(data & 0x0F));
             }
         }
     }
@@ -344,7 +345,7 @@ public:
 
         write_output(0);
 
-        cout << "[" << name << "] Initialisiert!" << endl;
+        LOG_INFO("[" << name << "] Initialisiert!");
     }
 
     bool send_byte_with_checksum(uint8_t byte)
@@ -355,23 +356,23 @@ public:
         {
             if (retry > 0)
             {
-                cout << "[" << name << "] WIEDERHOLUNG " << retry << "/" << MAX_RETRIES << endl;
+                LOG_DEBUG("[" << name << "] WIEDERHOLUNG " << retry << "/" << MAX_RETRIES);
                 global_stats.retransmissions++;
             }
 
-            cout << "[" << name << "] Sende Byte: '" << (char)byte << "' (0x"
-                 << hex << (int)byte << dec << ") + Checksum: 0x"
-                 << hex << (int)checksum << dec << endl;
+            LOG_DEBUG("[" << name << "] Sende Byte: '" << (char)byte << "' (0x"
+                      << hex << (int)byte << dec << ") + Checksum: 0x"
+                      << hex << (int)checksum << dec);
 
             if (!send_byte_raw(byte))
             {
-                cerr << "[" << name << "] Fehler beim Senden!" << endl;
+                LOG_WARN("[" << name << "] Fehler beim Senden!");
                 return false;
             }
 
             if (!send_byte_raw(checksum))
             {
-                cerr << "[" << name << "] Fehler beim Senden der Checksum!" << endl;
+                LOG_WARN("[" << name << "] Fehler beim Senden der Checksum!");
                 return false;
             }
 
@@ -379,32 +380,32 @@ public:
 
             if (response == ACK_BYTE)
             {
-                cout << "[" << name << "] << ACK empfangen! Byte erfolgreich uebertragen." << endl;
+                LOG_DEBUG("[" << name << "] << ACK empfangen! Byte erfolgreich uebertragen.");
                 global_stats.bytes_sent++;
                 return true;
             }
             else if (response == NACK_BYTE)
             {
-                cout << "[" << name << "] << NACK empfangen! Checksum-Fehler, wiederhole..." << endl;
+                LOG_DEBUG("[" << name << "] << NACK empfangen! Checksum-Fehler, wiederhole...");
             }
             else
             {
-                cout << "[" << name << "] << Unerwartete Antwort: 0x" << hex << (int)response << dec << endl;
+                LOG_DEBUG("[" << name << "] << Unerwartete Antwort: 0x" << hex << (int)response << dec);
             }
         }
 
-        cerr << "[" << name << "] XXX MAX RETRIES erreicht! Uebertragung fehlgeschlagen." << endl;
+        LOG_ERROR("[" << name << "] XXX MAX RETRIES erreicht! Uebertragung fehlgeschlagen.");
         return false;
     }
 
     uint8_t receive_byte_with_checksum()
     {
-        cout << "\n[" << name << "] Warte auf Byte..." << endl;
+        LOG_TRACE("[" << name << "] Warte auf Byte...");
 
         uint8_t byte = receive_byte_raw();
         if (byte == 0xFF)
         {
-            cerr << "[" << name << "] Timeout beim Empfangen!" << endl;
+            LOG_DEBUG("[" << name << "] Timeout beim Empfangen!");
             return 0xFF;
         }
 
@@ -413,26 +414,26 @@ public:
         uint8_t received_checksum = receive_byte_raw();
         if (received_checksum == 0xFF)
         {
-            cerr << "[" << name << "] Timeout beim Empfangen der Checksum!" << endl;
+            LOG_DEBUG("[" << name << "] Timeout beim Empfangen der Checksum!");
             return 0xFF;
         }
 
         uint8_t expected_checksum = calculate_checksum(received_byte);
 
-        cout << "[" << name << "] Empfangen: 0x" << hex << (int)received_byte << dec
-             << ", Checksum: 0x" << hex << (int)received_checksum << dec
-             << " (erwartet: 0x" << hex << (int)expected_checksum << dec << ")" << endl;
+        LOG_DEBUG("[" << name << "] Empfangen: 0x" << hex << (int)received_byte << dec
+                  << ", Checksum: 0x" << hex << (int)received_checksum << dec
+                  << " (erwartet: 0x" << hex << (int)expected_checksum << dec << ")");
 
         if (received_checksum == expected_checksum)
         {
-            cout << "[" << name << "] >> Checksum OK! Sende ACK." << endl;
+            LOG_DEBUG("[" << name << "] >> Checksum OK! Sende ACK.");
             send_byte_raw(ACK_BYTE);
             global_stats.bytes_received++;
             return received_byte;
         }
         else
         {
-            cout << "[" << name << "] XX Checksum FEHLER! Sende NACK." << endl;
+            LOG_DEBUG("[" << name << "] XX Checksum FEHLER! Sende NACK.");
             send_byte_raw(NACK_BYTE);
             global_stats.checksum_errors++;
             return 0xFF;
@@ -447,13 +448,14 @@ public:
         string line;
         while (getline(cin, line))
         {
-            cout << "[" << name << "] Sende Nachricht: \"" << line << "\"" << endl;
+            LOG_INFO("[" << name << "] Sende Nachricht: \"" << line << "\"");
 
             for (char c : line)
             {
                 if (!send_byte_with_checksum(c))
                 {
-                    cerr << "[" << name << "] Uebertragung abgebrochen!" << endl;
+                    LOG_ERROR("[" << name << "] Uebertragung abgebrochen!");
+                    AsyncLogger::instance().flush();
                     global_stats.print();
                     return;
                 }
@@ -461,22 +463,24 @@ public:
 
             if (!send_byte_with_checksum('\n'))
             {
-                cerr << "[" << name << "] Uebertragung abgebrochen!" << endl;
+                LOG_ERROR("[" << name << "] Uebertragung abgebrochen!");
+                AsyncLogger::instance().flush();
                 global_stats.print();
                 return;
             }
 
             if (!send_byte_with_checksum(EOT_BYTE))
             {
-                cerr << "[" << name << "] Uebertragung abgebrochen!" << endl;
+                LOG_ERROR("[" << name << "] Uebertragung abgebrochen!");
+                AsyncLogger::instance().flush();
                 global_stats.print();
                 return;
             }
 
-            cout << "[" << name << "] >>> Nachricht komplett gesendet! <<<\n"
-                 << endl;
+            LOG_INFO("[" << name << "] >>> Nachricht komplett gesendet! <<<\n");
         }
 
+        AsyncLogger::instance().flush();
         global_stats.print();
     }
 
@@ -498,16 +502,16 @@ public:
 
             if (byte == EOT_BYTE)
             {
-                cout << "[" << name << "] EOT empfangen! Nachricht komplett." << endl;
-                cout << "[" << name << "] EMPFANGENE NACHRICHT:" << endl;
-                cout << ">>> " << received_message << " <<<" << endl;
+                LOG_INFO("[" << name << "] EOT empfangen! Nachricht komplett.");
+                LOG_INFO("[" << name << "] EMPFANGENE NACHRICHT:");
+                LOG_INFO(">>> " << received_message << " <<<");
                 received_message = "";
                 continue;
             }
 
             received_message += (char)byte;
-            cout << "[" << name << "] Zeichen empfangen: '" << (char)byte
-                 << "' (Message bisher: \"" << received_message << "\")" << endl;
+            LOG_DEBUG("[" << name << "] Zeichen empfangen: '" << (char)byte
+                      << "' (Message bisher: \"" << received_message << "\")");
         }
     }
 
@@ -534,6 +538,7 @@ void *fullduplex_tx_thread(void *arg)
     string message;
     while (*(data->running))
     {
+        AsyncLogger::instance().flush();
         cout << "[" << sim->name << " TX] Eingabe: ";
         if (!getline(cin, message))
         {
@@ -554,7 +559,7 @@ void *fullduplex_tx_thread(void *arg)
             {
                 if (retry > 0)
                 {
-                    cout << "[" << sim->name << " TX] Retry " << retry << " fuer Byte '" << (char)byte << "'" << endl;
+                    LOG_DEBUG("[" << sim->name << " TX] Retry " << retry << " fuer Byte '" << (char)byte << "'");
                 }
 
                 pthread_mutex_lock(mutex);
@@ -569,7 +574,7 @@ void *fullduplex_tx_thread(void *arg)
 
             if (!success)
             {
-                cerr << "[" << sim->name << " TX] Uebertragung fehlgeschlagen!" << endl;
+                LOG_ERROR("[" << sim->name << " TX] Uebertragung fehlgeschlagen!");
                 break;
             }
         }
@@ -589,8 +594,7 @@ void *fullduplex_tx_thread(void *arg)
 
         if (eot_sent)
         {
-            cout << "[" << sim->name << " TX] >>> Nachricht gesendet! <<<\n"
-                 << endl;
+            LOG_INFO("[" << sim->name << " TX] >>> Nachricht gesendet! <<<\n");
         }
     }
 
@@ -626,8 +630,8 @@ void *fullduplex_rx_thread(void *arg)
 
         if (byte == EOT_BYTE)
         {
-            cout << "[" << sim->name << " RX] >>> NACHRICHT EMPFANGEN: \""
-                 << received_message << "\" <<<" << endl;
+            LOG_INFO("[" << sim->name << " RX] >>> NACHRICHT EMPFANGEN: \""
+                     << received_message << "\" <<<");
 
             if (outfile.is_open())
             {
@@ -681,6 +685,7 @@ void B15Simulator::run_fullduplex_mode()
 
     pthread_mutex_destroy(&cable_mutex);
 
+    AsyncLogger::instance().flush();
     cout << "\n[" << name << "] Full-Duplex Mode beendet." << endl;
     global_stats.print();
 }
@@ -0,0 +1,99 @@
+#ifndef GROUP_WRITER_H
+#define GROUP_WRITER_H
+
+#include "message_arena.h"
+#include "protocol.h"
+#include "stats.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Wann die Ausgabedatei zusätzlich mit fsync auf die Platte muss
+enum FsyncPolicy
+{
+    FSYNC_NONE = 0, // Nur write, den Rest macht der Page Cache
+    FSYNC_PERIODIC, // Höchstens einmal pro fsync_interval_ms
+    FSYNC_BATCH     // Nach jedem Schreib-Batch
+};
+
+// "none", "periodic" oder "batch"; false bei unbekanntem Namen
+bool parse_fsync_policy(const std::string &name, FsyncPolicy &policy);
+
+struct WriterSettings
+{
+    FsyncPolicy fsync_policy;
+    size_t max_batch_bytes; // Ab dieser Menge wird sofort geschrieben
+    int flush_interval_ms;  // Spätestens so lange bleibt eine Nachricht im Speicher
+    int fsync_interval_ms;  // Nur für FSYNC_PERIODIC
+
+    WriterSettings()
+        : fsync_policy(FSYNC_NONE), max_batch_bytes(64 * 1024), flush_interval_ms(100),
+          fsync_interval_ms(1000) {}
+};
+
+// Schreibt empfangene Nachrichten (je eine Zeile) gesammelt in eine Datei.
+// append() legt die Nachricht nur in den aktuellen Batch; ein eigener Thread
+// schreibt den Batch mit einem writev() pro Schwelle (Größe oder Zeit) statt
+// zwei Syscalls pro Nachricht. Geschriebene Strings wandern in einen Vorrat
+// und werden mit ihrer Kapazität wiederverwendet, append() allokiert also
+// nur, bis der Vorrat warm ist. Bei Abbruch per Ctrl+C gehen höchstens die
+// Nachrichten des letzten flush_interval_ms verloren; der Destruktor
+// schreibt alles Ausstehende. Der Rückstand (backlog()) bestimmt den Credit,
+// den der Empfänger der Gegenseite meldet: hängt die Platte, pausiert der
+// Sender, statt dass pending unbegrenzt wächst. Schlägt das Schreiben fehl
+// (z.B. ENOSPC, EIO), bleibt der ungeschriebene Rest vorne im Batch und wird
+// nach flush_interval_ms erneut versucht; der Fehler geht in die Stats.
+class GroupCommitWriter : public BacklogSource
+{
+public:
+    explicit GroupCommitWriter(const WriterSettings &settings = WriterSettings());
+    ~GroupCommitWriter();
+
+    // Hängt an die Datei an. false mit Fehlermeldung in error.
+    bool open(const std::string &path, std::string &error);
+    bool is_open() const { return fd >= 0; }
+
+    // Nachricht ohne Zeilenende, '\n' hängt der Writer an. Die Bytes werden
+    // kopiert, span darf danach wiederverwendet werden.
+    void append(const ByteSpan &message);
+
+    // Schreibt den aktuellen Batch sofort (und fsync bei FSYNC_BATCH)
+    void flush();
+
+    // Angehängte Bytes, die noch nicht geschrieben sind
+    size_t backlog();
+
+    // Zählt Schreibfehler, Default: global_stats
+    void set_stats(Stats *s) { stats = s; }
+
+private:
+    WriterSettings settings;
+    int fd;
+    Stats *stats;
+
+    std::mutex mtx;
+    std::condition_variable wakeup;
+    std::vector<std::string> pending;
+    std::vector<std::string> spare; // Geschriebene Strings zur Wiederverwendung
+    size_t pending_bytes;
+    size_t writing_bytes; // Batch, der gerade geschrieben wird
+    bool stopping;
+    bool write_failed; // Letzter Versuch gescheitert, Worker wartet das Intervall ab
+    std::thread worker;
+
+    std::mutex write_mtx; // Serialisiert flush() und den Worker
+    std::vector<std::string> writing;
+    uint64_t last_fsync_ns;
+    bool unsynced; // Geschrieben, aber noch nicht per fsync gesichert
+
+    void run();
+    void write_batch();
+    void requeue_unwritten(size_t written);
+    void sync_file();
+};
+
+#endif // GROUP_WRITER_H
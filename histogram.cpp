@@ -0,0 +1,143 @@
+#include "histogram.h"
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void LatencyHistogram::reset()
+{
+    for (int i = 0; i < BUCKETS; i++)
+    {
+        counts[i].store(0, memory_order_relaxed);
+    }
+    total.store(0, memory_order_relaxed);
+    sum.store(0, memory_order_relaxed);
+    max_value.store(0, memory_order_relaxed);
+}
+
+int LatencyHistogram::bucket_index(uint64_t value)
+{
+    if (value < (uint64_t)SUB_BUCKETS)
+    {
+        return (int)value;
+    }
+
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - SUB_BUCKET_BITS;
+    int sub = (int)(value >> shift) - SUB_BUCKETS;
+    return (shift + 1) * SUB_BUCKETS + sub;
+}
+
+uint64_t LatencyHistogram::bucket_upper_value(int index)
+{
+    if (index < SUB_BUCKETS)
+    {
+        return index;
+    }
+
+    int shift = index / SUB_BUCKETS - 1;
+    uint64_t sub = index % SUB_BUCKETS;
+    uint64_t lower = (SUB_BUCKETS + sub) << shift;
+    return lower + ((uint64_t)1 << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value_ns)
+{
+    counts[bucket_index(value_ns)].fetch_add(1, memory_order_relaxed);
+    total.fetch_add(1, memory_order_relaxed);
+    sum.fetch_add(value_ns, memory_order_relaxed);
+
+    uint64_t current = max_value.load(memory_order_relaxed);
+    while (value_ns > current &&
+           !max_value.compare_exchange_weak(current, value_ns, memory_order_relaxed))
+    {
+    }
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    for (int i = 0; i < BUCKETS; i++)
+    {
+        uint64_t n = other.counts[i].load(memory_order_relaxed);
+        if (n > 0)
+        {
+            counts[i].fetch_add(n, memory_order_relaxed);
+        }
+    }
+    total.fetch_add(other.total.load(memory_order_relaxed), memory_order_relaxed);
+    sum.fetch_add(other.sum.load(memory_order_relaxed), memory_order_relaxed);
+
+    uint64_t value = other.max();
+    uint64_t current = max_value.load(memory_order_relaxed);
+    while (value > current &&
+           !max_value.compare_exchange_weak(current, value, memory_order_relaxed))
+    {
+    }
+}
+
+uint64_t LatencyHistogram::count() const
+{
+    return total.load(memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::max() const
+{
+    return max_value.load(memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const
+{
+    uint64_t n = count();
+    return n > 0 ? (double)sum.load(memory_order_relaxed) / n : 0.0;
+}
+
+uint64_t LatencyHistogram::percentile(double p) const
+{
+    uint64_t n = count();
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t)(p / 100.0 * n + 0.5);
+    if (rank < 1)
+        rank = 1;
+    if (rank > n)
+        rank = n;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; i++)
+    {
+        seen += counts[i].load(memory_order_relaxed);
+        if (seen >= rank)
+        {
+            uint64_t value = bucket_upper_value(i);
+            return value < max() ? value : max();
+        }
+    }
+    return max();
+}
+
+void LatencyHistogram::print(const string &label, double divisor, const string &unit) const
+{
+    if (count() == 0)
+    {
+        return;
+    }
+
+    cout << fixed << setprecision(1);
+    cout << "  " << left << setw(18) << label << right
+         << " n=" << count()
+         << "  p50=" << percentile(50) / divisor
+         << "  p90=" << percentile(90) / divisor
+         << "  p99=" << percentile(99) / divisor
+         << "  p99.9=" << percentile(99.9) / divisor
+         << "  max=" << max() / divisor << (unit.empty() ? "" : " ") << unit << endl;
+    cout.unsetf(ios::floatfield);
+    cout << setprecision(6);
+}
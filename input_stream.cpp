@@ -0,0 +1,114 @@
+#include "input_stream.h"
+#include <algorithm>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Höchstens so viel pro read()-Aufruf
+static const size_t BLOCK_SIZE = 64 * 1024;
+
+InputStream::InputStream(int fd, size_t capacity) : state(make_shared<State>(capacity))
+{
+#ifdef _WIN32
+    // Sonst wandelt die CRT \r\n um und bricht bei Ctrl+Z ab
+    _setmode(fd, _O_BINARY);
+#endif
+    reader = thread(&InputStream::run, state, fd);
+}
+
+InputStream::~InputStream()
+{
+    state->closing.store(true);
+    state->space_ready.notify();
+
+    if (state->finished.load())
+        reader.join();
+    else
+        reader.detach();
+}
+
+void InputStream::run(shared_ptr<State> s, int fd)
+{
+    while (!s->closing.load(memory_order_relaxed))
+    {
+        // Direkt in den freien Bereich des Rings lesen, ohne Zwischenpuffer
+        uint8_t *window;
+        size_t want = s->ring.write_window(window);
+        if (want == 0)
+        {
+            s->space_ready.wait([&]()
+                                { return s->closing.load() || s->ring.size() < s->ring.capacity(); });
+            continue;
+        }
+
+#ifdef _WIN32
+        int n = _read(fd, window, (unsigned)min(want, BLOCK_SIZE));
+#else
+        ssize_t n = ::read(fd, window, min(want, BLOCK_SIZE));
+#endif
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+
+        s->ring.commit_write(n);
+        s->data_ready.notify();
+    }
+
+    s->finished.store(true, memory_order_release);
+    s->data_ready.notify();
+}
+
+size_t InputStream::read(uint8_t *dst, size_t max)
+{
+    State &s = *state;
+    for (;;)
+    {
+        size_t n = s.ring.pop(dst, max);
+        if (n > 0)
+        {
+            s.space_ready.notify();
+            return n;
+        }
+
+        // Erst finished prüfen, dann den Ring erneut: sonst ginge ein Block
+        // verloren, den der Leser kurz vor dem Ende noch eingestellt hat
+        if (s.finished.load(memory_order_acquire))
+            return s.ring.pop(dst, max);
+
+        s.data_ready.wait([&]()
+                          { return s.finished.load() || s.ring.size() > 0; });
+    }
+}
+
+size_t InputStream::try_read(uint8_t *dst, size_t max, bool &eof)
+{
+    State &s = *state;
+    eof = false;
+    size_t n = s.ring.pop(dst, max);
+    if (n > 0)
+    {
+        s.space_ready.notify();
+        return n;
+    }
+
+    // Reihenfolge wie in read()
+    if (!s.finished.load(memory_order_acquire))
+        return 0;
+
+    n = s.ring.pop(dst, max);
+    eof = n == 0;
+    return n;
+}
+
+size_t InputStream::buffered() const
+{
+    return state->ring.size();
+}
@@ -0,0 +1,699 @@
+#include "link_daemon.h"
+#include "input_stream.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+static const size_t MAX_HEADER = 64; // "SEND <n> <kanal>" ist viel kürzer
+
+string default_daemon_socket(const string &board)
+{
+    return "b15link_" + board + ".sock";
+}
+
+LinkDaemon::LinkDaemon(const string &path, size_t max_queue)
+    : socket_path(path), max_queue_bytes(max_queue), listen_fd(-1), stopping(false), next_client_id(1),
+      next_message_id(1), outgoing_bytes(0)
+{
+    wake_pipe[0] = wake_pipe[1] = -1;
+}
+
+LinkDaemon::~LinkDaemon()
+{
+    stop();
+}
+
+#ifdef _WIN32
+
+bool LinkDaemon::start(string &error)
+{
+    error = "Daemon-Modus gibt es nur unter Linux/Unix";
+    return false;
+}
+
+void LinkDaemon::stop() {}
+void LinkDaemon::wake() {}
+void LinkDaemon::run() {}
+
+int run_daemon_submit(const string &, int)
+{
+    cerr << "Daemon-Modus gibt es nur unter Linux/Unix" << endl;
+    return 1;
+}
+
+int run_daemon_subscribe(const string &)
+{
+    cerr << "Daemon-Modus gibt es nur unter Linux/Unix" << endl;
+    return 1;
+}
+
+#else
+
+static bool make_address(const string &path, sockaddr_un &addr, string &error)
+{
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+    {
+        error = "Socket-Pfad zu lang: " + path;
+        return false;
+    }
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+static int connect_socket(const string &path, string &error)
+{
+    sockaddr_un addr;
+    if (!make_address(path, addr, error))
+        return -1;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        error = "Keine Verbindung zu " + path + " (" + strerror(errno) + ")";
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void set_nonblocking(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+}
+
+bool LinkDaemon::start(string &error)
+{
+    sockaddr_un addr;
+    if (!make_address(socket_path, addr, error))
+        return false;
+
+    // Antwortet der Socket noch, läuft schon ein Daemon; sonst ist die Datei
+    // ein Überbleibsel eines abgebrochenen Laufs
+    string ignored;
+    int probe = connect_socket(socket_path, ignored);
+    if (probe >= 0)
+    {
+        close(probe);
+        error = "Auf " + socket_path + " laeuft bereits ein Daemon";
+        return false;
+    }
+    unlink(socket_path.c_str());
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0 || bind(listen_fd, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(listen_fd, 16) != 0)
+    {
+        error = "Socket " + socket_path + " nicht anlegbar (" + strerror(errno) + ")";
+        if (listen_fd >= 0)
+            close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+    set_nonblocking(listen_fd);
+
+    if (pipe(wake_pipe) != 0)
+    {
+        error = string("pipe fehlgeschlagen (") + strerror(errno) + ")";
+        stop();
+        return false;
+    }
+    set_nonblocking(wake_pipe[0]);
+    set_nonblocking(wake_pipe[1]);
+
+    // Ein Client, der mitten im Schreiben verschwindet, soll nicht den
+    // ganzen Daemon beenden
+    signal(SIGPIPE, SIG_IGN);
+
+    stopping = false;
+    worker = thread(&LinkDaemon::run, this);
+    return true;
+}
+
+void LinkDaemon::stop()
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        stopping = true;
+    }
+    outgoing_ready.notify_all();
+    wake();
+    if (worker.joinable())
+        worker.join();
+
+    for (map<uint64_t, Client>::iterator it = clients.begin(); it != clients.end(); ++it)
+        close(it->second.fd);
+    clients.clear();
+
+    if (listen_fd >= 0)
+    {
+        close(listen_fd);
+        unlink(socket_path.c_str());
+        listen_fd = -1;
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        if (wake_pipe[i] >= 0)
+            close(wake_pipe[i]);
+        wake_pipe[i] = -1;
+    }
+}
+
+// Weckt poll() im Client-Thread, z.B. wenn neue Antworten anstehen
+void LinkDaemon::wake()
+{
+    if (wake_pipe[1] >= 0)
+    {
+        char c = 0;
+        ssize_t ignored = write(wake_pipe[1], &c, 1);
+        (void)ignored;
+    }
+}
+
+void LinkDaemon::run()
+{
+    vector<pollfd> fds;
+    vector<uint64_t> ids;
+
+    while (!stopping)
+    {
+        fds.clear();
+        ids.clear();
+        {
+            lock_guard<mutex> lock(mtx);
+            // Volle Warteschlange: nichts mehr lesen, die Sender blockieren
+            bool accept_input = outgoing_bytes < max_queue_bytes;
+
+            pollfd p;
+            p.fd = listen_fd;
+            p.events = POLLIN;
+            fds.push_back(p);
+            p.fd = wake_pipe[0];
+            fds.push_back(p);
+
+            for (map<uint64_t, Client>::iterator it = clients.begin(); it != clients.end(); ++it)
+            {
+                p.fd = it->second.fd;
+                p.events = 0;
+                if (accept_input && !it->second.closing)
+                    p.events |= POLLIN;
+                if (!it->second.output.empty())
+                    p.events |= POLLOUT;
+                fds.push_back(p);
+                ids.push_back(it->first);
+            }
+        }
+
+        if (poll(fds.data(), fds.size(), 100) <= 0)
+            continue;
+
+        if (fds[1].revents & POLLIN)
+        {
+            char drain[256];
+            while (read(wake_pipe[0], drain, sizeof(drain)) > 0)
+            {
+            }
+        }
+
+        if (fds[0].revents & POLLIN)
+            accept_clients();
+
+        lock_guard<mutex> lock(mtx);
+        for (size_t i = 0; i < ids.size(); i++)
+        {
+            short revents = fds[i + 2].revents;
+            map<uint64_t, Client>::iterator it = clients.find(ids[i]);
+            if (it == clients.end())
+                continue;
+            Client &client = it->second;
+
+            bool ok = true;
+            if (revents & (POLLIN | POLLHUP | POLLERR))
+                ok = read_client(it->first, client);
+            if (ok && (revents & POLLOUT))
+                ok = write_client(client);
+
+            if (!ok || (client.closing && client.output.empty()))
+            {
+                close_client(client);
+                clients.erase(it);
+            }
+        }
+    }
+}
+
+void LinkDaemon::accept_clients()
+{
+    int fd;
+    while ((fd = accept(listen_fd, nullptr, nullptr)) >= 0)
+    {
+        set_nonblocking(fd);
+
+        Client client;
+        client.fd = fd;
+        client.subscriber = false;
+        client.closing = false;
+        client.expect = 0;
+        client.channel = 0;
+        client.in_body = false;
+
+        lock_guard<mutex> lock(mtx);
+        clients[next_client_id++] = client;
+    }
+}
+
+// false, wenn die Verbindung zu ist
+bool LinkDaemon::read_client(uint64_t id, Client &client)
+{
+    char buf[64 * 1024];
+    ssize_t n = read(client.fd, buf, sizeof(buf));
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        return true;
+    if (n <= 0)
+        return false;
+
+    client.input.append(buf, (size_t)n);
+    return parse_input(id, client);
+}
+
+bool LinkDaemon::parse_input(uint64_t id, Client &client)
+{
+    while (!client.closing)
+    {
+        if (client.in_body)
+        {
+            if (client.input.size() < client.expect)
+                return true;
+
+            PendingMessage message;
+            message.client = id;
+            message.id = next_message_id++;
+            message.data.assign(client.input.begin(), client.input.begin() + client.expect);
+            message.offset = 0;
+            client.input.erase(0, client.expect);
+            client.in_body = false;
+
+            outgoing_bytes += message.data.size();
+            outgoing[client.channel].push_back(move(message));
+            outgoing_ready.notify_one();
+            continue;
+        }
+
+        size_t newline = client.input.find('\n');
+        if (newline == string::npos)
+        {
+            if (client.input.size() > MAX_HEADER)
+                break;
+            return true;
+        }
+
+        string line = client.input.substr(0, newline);
+        client.input.erase(0, newline + 1);
+
+        if (line == "SUBSCRIBE")
+        {
+            client.subscriber = true;
+            continue;
+        }
+
+        if (line.compare(0, 5, "SEND ") == 0)
+        {
+            char *end;
+            unsigned long long size = strtoull(line.c_str() + 5, &end, 10);
+            if (end == line.c_str() + 5)
+                break;
+            long channel = 0;
+            if (*end == ' ')
+            {
+                const char *start = end + 1;
+                channel = strtol(start, &end, 10);
+                if (end == start || channel < 0 || channel >= MAX_CHANNELS)
+                    break;
+            }
+            if (*end != '\0')
+                break;
+            if (size > max_queue_bytes)
+            {
+                client.output += "ERR Nachricht zu gross\n";
+                client.closing = true;
+                return true;
+            }
+            client.expect = (size_t)size;
+            client.channel = (int)channel;
+            client.in_body = true;
+            continue;
+        }
+
+        break;
+    }
+
+    if (!client.closing)
+    {
+        client.output += "ERR unbekannter Befehl\n";
+        client.closing = true;
+    }
+    client.input.clear();
+    return true;
+}
+
+bool LinkDaemon::write_client(Client &client)
+{
+    ssize_t n = write(client.fd, client.output.data(), client.output.size());
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        return true;
+    if (n <= 0)
+        return false;
+
+    client.output.erase(0, (size_t)n);
+    return true;
+}
+
+void LinkDaemon::close_client(Client &client)
+{
+    close(client.fd);
+}
+
+#endif // _WIN32
+
+bool LinkDaemon::next_frame(OutgoingFrame &frame, int timeout_ms)
+{
+    {
+        unique_lock<mutex> lock(mtx);
+        int channel = -1;
+        outgoing_ready.wait_for(lock, chrono::milliseconds(timeout_ms), [&] {
+            for (channel = 0; channel < MAX_CHANNELS; channel++)
+            {
+                if (!outgoing[channel].empty())
+                    return true;
+            }
+            return (bool)stopping;
+        });
+        if (channel < 0 || channel >= MAX_CHANNELS)
+            return false;
+
+        // Strikte Priorität: der kleinste Kanal mit Daten, dort die älteste
+        // Nachricht. Eine angefangene Nachricht auf einem höheren Kanal
+        // wartet, bis hier nichts mehr ansteht.
+        PendingMessage &message = outgoing[channel].front();
+        size_t length = min(FRAME_BYTES, message.data.size() - message.offset);
+
+        frame.client = message.client;
+        frame.message = message.id;
+        frame.channel = channel;
+        frame.data.assign(message.data.begin() + message.offset, message.data.begin() + message.offset + length);
+        frame.first = message.offset == 0;
+        message.offset += length;
+        frame.last = message.offset == message.data.size();
+        outgoing_bytes -= length;
+
+        if (frame.last)
+            outgoing[channel].pop_front();
+    }
+
+    // Wieder Platz: Sender weiterlesen lassen
+    wake();
+    return true;
+}
+
+// Rest einer Nachricht verwerfen, Client bekommt FAIL. Aufruf mit mtx.
+void LinkDaemon::fail_message(deque<PendingMessage> &queue, size_t index)
+{
+    PendingMessage &message = queue[index];
+    outgoing_bytes -= message.data.size() - message.offset;
+
+    map<uint64_t, Client>::iterator it = clients.find(message.client);
+    if (it != clients.end() && !it->second.closing)
+        it->second.output += "FAIL\n";
+    queue.erase(queue.begin() + index);
+}
+
+void LinkDaemon::sent(const OutgoingFrame &frame, bool success)
+{
+    if (success && !frame.last)
+        return; // Bestätigt wird erst die ganze Nachricht
+
+    {
+        lock_guard<mutex> lock(mtx);
+        if (!frame.last)
+        {
+            deque<PendingMessage> &queue = outgoing[frame.channel];
+            for (size_t i = 0; i < queue.size(); i++)
+            {
+                if (queue[i].id == frame.message)
+                {
+                    fail_message(queue, i);
+                    break;
+                }
+            }
+        }
+        else
+        {
+            map<uint64_t, Client>::iterator it = clients.find(frame.client);
+            if (it == clients.end() || it->second.closing)
+                return; // Client schon weg
+            it->second.output += success ? "OK\n" : "FAIL\n";
+        }
+    }
+    wake();
+}
+
+void LinkDaemon::abort_started()
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        for (int channel = 0; channel < MAX_CHANNELS; channel++)
+        {
+            // Angefangen ist höchstens die vorderste Nachricht eines Kanals
+            deque<PendingMessage> &queue = outgoing[channel];
+            if (!queue.empty() && queue.front().offset > 0)
+                fail_message(queue, 0);
+        }
+    }
+    wake();
+}
+
+void LinkDaemon::deliver(int channel, const ByteSpan &message)
+{
+    string header = "MSG " + to_string((unsigned long long)message.size) + " " + to_string(channel) + "\n";
+    {
+        lock_guard<mutex> lock(mtx);
+        for (map<uint64_t, Client>::iterator it = clients.begin(); it != clients.end(); ++it)
+        {
+            Client &client = it->second;
+            if (!client.subscriber || client.closing)
+                continue;
+
+            if (client.output.size() + header.size() + message.size > max_queue_bytes)
+            {
+                cerr << "[DAEMON] Abonnent getrennt, liest zu langsam" << endl;
+                client.output.clear();
+                client.closing = true;
+                continue;
+            }
+            client.output += header;
+            client.output.append((const char *)message.data, message.size);
+        }
+    }
+    wake();
+}
+
+size_t LinkDaemon::queued_bytes()
+{
+    lock_guard<mutex> lock(mtx);
+    return outgoing_bytes;
+}
+
+#ifndef _WIN32
+
+// Blockierendes Lesen vom Daemon, zeilenweise oder mit fester Länge
+class SocketReader
+{
+public:
+    explicit SocketReader(int f) : fd(f) {}
+
+    bool read_line(string &line)
+    {
+        size_t newline;
+        while ((newline = buffer.find('\n')) == string::npos)
+        {
+            if (!fill())
+                return false;
+        }
+        line = buffer.substr(0, newline);
+        buffer.erase(0, newline + 1);
+        return true;
+    }
+
+    bool read_exact(size_t n, string &data)
+    {
+        while (buffer.size() < n)
+        {
+            if (!fill())
+                return false;
+        }
+        data = buffer.substr(0, n);
+        buffer.erase(0, n);
+        return true;
+    }
+
+private:
+    int fd;
+    string buffer;
+
+    bool fill()
+    {
+        char buf[64 * 1024];
+        ssize_t n;
+        do
+        {
+            n = read(fd, buf, sizeof(buf));
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0)
+            return false;
+        buffer.append(buf, (size_t)n);
+        return true;
+    }
+};
+
+static bool write_all(int fd, const char *data, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = write(fd, data, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+int run_daemon_submit(const string &socket_path, int channel)
+{
+    string error;
+    int fd = connect_socket(socket_path, error);
+    if (fd < 0)
+    {
+        cerr << error << endl;
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    SocketReader reader(fd);
+    InputStream input;
+    uint8_t block[4096];
+    string line;
+    int failed = 0;
+    bool connected = true;
+
+    // Wie im Full-Duplex-Modus: jede Zeile eine Nachricht, leere entfallen.
+    // Eine Zeile nach der anderen, der Daemon bestätigt erst nach dem Link.
+    size_t n;
+    bool input_done = false;
+    while (connected && !input_done)
+    {
+        n = input.read(block, sizeof(block));
+        input_done = (n == 0);
+
+        for (size_t i = 0; i <= n && connected; i++)
+        {
+            bool end_of_line = (i == n) ? input_done : block[i] == '\n';
+            if (!end_of_line)
+            {
+                if (i < n)
+                    line += (char)block[i];
+                continue;
+            }
+            if (line.empty())
+                continue;
+
+            string header =
+                "SEND " + to_string((unsigned long long)line.size()) + " " + to_string(channel) + "\n";
+            string reply;
+            connected = write_all(fd, header.data(), header.size()) && write_all(fd, line.data(), line.size()) &&
+                        reader.read_line(reply);
+            if (connected && reply != "OK")
+            {
+                cerr << "[SUBMIT] Daemon: " << reply << endl;
+                failed++;
+            }
+            line.clear();
+        }
+    }
+
+    close(fd);
+    if (!connected)
+    {
+        cerr << "[SUBMIT] Verbindung zum Daemon verloren" << endl;
+        return 1;
+    }
+    return failed > 0 ? 1 : 0;
+}
+
+int run_daemon_subscribe(const string &socket_path)
+{
+    string error;
+    int fd = connect_socket(socket_path, error);
+    if (fd < 0)
+    {
+        cerr << error << endl;
+        return 1;
+    }
+
+    signal(SIGPIPE, SIG_IGN); // Geschlossenes stdout als Schreibfehler melden
+
+    static const char request[] = "SUBSCRIBE\n";
+    if (!write_all(fd, request, sizeof(request) - 1))
+    {
+        cerr << "[SUBSCRIBE] Verbindung zum Daemon verloren" << endl;
+        close(fd);
+        return 1;
+    }
+
+    // Framing des Daemons unverändert weiterreichen, die Nachrichten selbst
+    // dürfen '\n' und beliebige Binärdaten enthalten
+    SocketReader reader(fd);
+    string header, message;
+    bool output_ok = true;
+    while (output_ok && reader.read_line(header))
+    {
+        if (header.compare(0, 4, "MSG ") != 0)
+        {
+            cerr << "[SUBSCRIBE] Daemon: " << header << endl;
+            break;
+        }
+        if (!reader.read_exact((size_t)strtoull(header.c_str() + 4, nullptr, 10), message))
+            break;
+
+        header += '\n';
+        output_ok = write_all(STDOUT_FILENO, header.data(), header.size()) &&
+                    write_all(STDOUT_FILENO, message.data(), message.size());
+    }
+
+    close(fd);
+    if (!output_ok)
+    {
+        cerr << "[SUBSCRIBE] stdout geschlossen: " << strerror(errno) << endl;
+        return 1;
+    }
+    return 0;
+}
+
+#endif // _WIN32
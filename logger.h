@@ -0,0 +1,221 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+// Asynchroner Logger für den Protokollpfad.
+//
+// Protokoll-Threads formatieren nur eine Zeile und legen sie in eine lock-freie
+// Warteschlange (begrenzter MPMC-Ring nach Vyukov). Ein Hintergrund-Thread
+// schreibt sie in den Ausgabestrom und flusht nur, wenn die Schlange leer ist.
+// Ist die Schlange voll, wird die Zeile verworfen statt zu blockieren.
+//
+// Stufen oberhalb von LOG_COMPILE_LEVEL werden gar nicht erst kompiliert
+// (z.B. -DLOG_COMPILE_LEVEL=3 entfernt DEBUG und TRACE). Zur Laufzeit gilt
+// zusätzlich set_level(), Standard ist INFO: nichts pro Byte.
+//
+// Nur Header, damit auch die Einzeldatei-Programme (finale.cpp,
+// simulator_END.cpp) ihn ohne eigenes Build-Target nutzen können.
+
+enum LogLevel
+{
+    LOG_LEVEL_OFF = 0,
+    LOG_LEVEL_ERROR = 1,
+    LOG_LEVEL_WARN = 2,
+    LOG_LEVEL_INFO = 3,  // Pro Nachricht
+    LOG_LEVEL_DEBUG = 4, // Pro Byte
+    LOG_LEVEL_TRACE = 5  // Pro Nibble / Registerzugriff
+};
+
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_TRACE
+#endif
+
+class AsyncLogger
+{
+public:
+    static const size_t CAPACITY = 4096; // Zweierpotenz
+
+    static AsyncLogger &instance()
+    {
+        static AsyncLogger logger;
+        return logger;
+    }
+
+    bool enabled(int level) const { return level <= current_level.load(std::memory_order_relaxed); }
+    void set_level(int level) { current_level.store(level, std::memory_order_relaxed); }
+
+    // Z.B. &std::cerr, wenn stdout für Nutzdaten frei bleiben muss
+    void set_sink(std::ostream *out)
+    {
+        flush();
+        sink.store(out);
+    }
+
+    uint64_t dropped() const { return dropped_count.load(std::memory_order_relaxed); }
+
+    // Von beliebig vielen Threads; kehrt sofort zurück
+    void push(std::string &&line)
+    {
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Slot &slot = slots[pos & (CAPACITY - 1)];
+            size_t seq = slot.sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+            if (diff == 0)
+            {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    slot.line = std::move(line);
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return;
+                }
+            }
+            else if (diff < 0)
+            {
+                dropped_count.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            else
+            {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Wartet, bis alles bis jetzt Eingereihte geschrieben und geflusht ist,
+    // z.B. vor Stats::print() oder einer Eingabeaufforderung
+    void flush()
+    {
+        size_t target = enqueue_pos.load(std::memory_order_acquire);
+        while (written.load(std::memory_order_acquire) < target)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+
+    ~AsyncLogger()
+    {
+        stopping.store(true);
+        writer.join();
+
+        uint64_t lost = dropped();
+        if (lost > 0)
+        {
+            std::cerr << "[LOG] " << lost << " Zeilen verworfen (Warteschlange voll)" << std::endl;
+        }
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        std::string line;
+    };
+
+    Slot slots[CAPACITY];
+    alignas(64) std::atomic<size_t> enqueue_pos;
+    alignas(64) std::atomic<size_t> dequeue_pos;
+    alignas(64) std::atomic<size_t> written;
+    std::atomic<int> current_level;
+    std::atomic<std::ostream *> sink;
+    std::atomic<uint64_t> dropped_count;
+    std::atomic<bool> stopping;
+    std::thread writer;
+
+    AsyncLogger()
+        : enqueue_pos(0), dequeue_pos(0), written(0), current_level(LOG_LEVEL_INFO),
+          sink(&std::cout), dropped_count(0), stopping(false)
+    {
+        for (size_t i = 0; i < CAPACITY; i++)
+        {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        writer = std::thread(&AsyncLogger::run, this);
+    }
+
+    // Nur der Writer-Thread liest
+    bool pop(std::string &line)
+    {
+        size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        Slot &slot = slots[pos & (CAPACITY - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != pos + 1)
+            return false;
+
+        line = std::move(slot.line);
+        slot.sequence.store(pos + CAPACITY, std::memory_order_release);
+        dequeue_pos.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void run()
+    {
+        std::string line;
+        for (;;)
+        {
+            std::ostream *out = sink.load();
+            size_t n = 0;
+            while (pop(line))
+            {
+                *out << line << '\n';
+                n++;
+            }
+
+            if (n > 0)
+            {
+                out->flush();
+                written.fetch_add(n, std::memory_order_release);
+            }
+            else if (stopping.load())
+            {
+                break;
+            }
+            else
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+};
+
+#define LOG_AT(level, expr)                                                        \
+    do                                                                             \
+    {                                                                              \
+        if ((level) <= LOG_COMPILE_LEVEL && AsyncLogger::instance().enabled(level)) \
+        {                                                                          \
+            std::ostringstream log_stream_;                                        \
+            log_stream_ << expr;                                                   \
+            AsyncLogger::instance().push(log_stream_.str());                       \
+        }                                                                          \
+    } while (0)
+
+#define LOG_ERROR(expr) LOG_AT(LOG_LEVEL_ERROR, expr)
+#define LOG_WARN(expr) LOG_AT(LOG_LEVEL_WARN, expr)
+#define LOG_INFO(expr) LOG_AT(LOG_LEVEL_INFO, expr)
+#define LOG_DEBUG(expr) LOG_AT(LOG_LEVEL_DEBUG, expr)
+#define LOG_TRACE(expr) LOG_AT(LOG_LEVEL_TRACE, expr)
+
+// Für Kommandozeilen-Optionen wie --log=debug
+inline bool parse_log_level(const std::string &name, int &level)
+{
+    static const char *names[] = {"off", "error", "warn", "info", "debug", "trace"};
+    for (int i = 0; i <= LOG_LEVEL_TRACE; i++)
+    {
+        if (name == names[i])
+        {
+            level = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif // LOGGER_H
@@ -1,7 +1,18 @@
 #include "b15simulator.h"
 #include "error_injector.h"
+#include "wire_faults.h"
+#include "fault_scenario.h"
+#include "stats_export.h"
+#include "trace.h"
+#include "logger.h"
+#include "dashboard.h"
+#include "perf_counters.h"
 #include <iostream>
+#include <csignal>
 #include <cstdlib>
+#include <memory>
+#include <vector>
+#include <sys/stat.h>
 
 using namespace std;
 
@@ -9,10 +20,38 @@ int main(int argc, char *argv[])
 {
     if (argc < 3)
     {
-        cout << "Usage: " << argv[0] << " <board> <mode> [error_rate]" << endl;
+        cout << "Usage: " << argv[0] << " <board> <mode> [error_rate] [--fault=<spec>...] [--scenario=<file>]" << endl;
+        cout << "       [--stats-out=<prefix>] [--stats-interval=<s>] [--trace=<file>]" << endl;
+        cout << "       [--log=<level>] [--dashboard[=<ms>]] [--perf[=<regionen>]] [--file=<pfad>]" << endl;
+        cout << "       [--fsync=<policy>] [--max-message=<bytes>] [--spill-dir=<dir>] [--raw]" << endl;
+        cout << "       [--socket=<pfad>] [--channel=<n>] [--rx-window=<bytes>]" << endl;
         cout << "  board:      A oder B" << endl;
-        cout << "  mode:       send, receive, oder fullduplex" << endl;
-        cout << "  error_rate: 0-100 (optional, default: 0)" << endl;
+        cout << "  mode:       send, send-file, receive, fullduplex, daemon, submit oder subscribe" << endl;
+        cout << "              daemon: haelt den Link warm, Clients ueber einen Unix-Socket" << endl;
+        cout << "              submit: stdin zeilenweise an den Daemon, subscribe: Empfang vom Daemon" << endl;
+        cout << "  error_rate: 0-100 in Prozent, auch Dezimalwerte wie 0.1 (optional, default: 0)" << endl;
+        cout << "  --fault:    Leitungsfehler auf den eingehenden Leitungen (mehrfach moeglich)" << endl;
+        cout << "              stuck0:<wires>, stuck1:<wires>, glitch:<wires>:<p>," << endl;
+        cout << "              delay:<wires>:<reads>, toggle:<wires>:<p>[:<reads>]" << endl;
+        cout << "              wires: data0, data1, clock, ack, all (kombinierbar mit +)" << endl;
+        cout << "  --scenario: Datei mit zeit-/bytegesteuertem Fehlerablauf (siehe scenario.txt)" << endl;
+        cout << "  --stats-out:      Schreibt <prefix>.json, .csv und .prom periodisch" << endl;
+        cout << "  --stats-interval: Export-Intervall in Sekunden (default: 5)" << endl;
+        cout << "  --trace:    Datei fuer den Trace-Dump bei SIGUSR1 oder Abbruch" << endl;
+        cout << "              (default: trace_<board>.bin, lesbar mit tracetool.exe)" << endl;
+        cout << "  --log:      off, error, warn, info (default), debug (pro Byte), trace (pro Nibble)" << endl;
+        cout << "  --dashboard: Live-Statuszeile auf stderr, Refresh in ms (default: 250)" << endl;
+        cout << "  --perf:     perf_event-Zaehler (Linux) pro Symbol/Byte: symbol, byte, all (default)" << endl;
+        cout << "  --file:     Quelldatei fuer send-file (wird per mmap gelesen, auch binaer)" << endl;
+        cout << "  --fsync:    received_X.txt sichern: none (default), periodic (1 s), batch" << endl;
+        cout << "  --max-message: Groessere Nachrichten in eine Spill-Datei auslagern" << endl;
+        cout << "                 (default: 64M, Suffix K/M/G, 0 = unbegrenzt im Speicher)" << endl;
+        cout << "  --spill-dir:   Verzeichnis der Spill-Dateien (default: .)" << endl;
+        cout << "  --rx-window:   Rueckstand von received_X.txt bzw. --raw, ab dem der Sender" << endl;
+        cout << "                 per Credit pausiert (default: 0 = aus)" << endl;
+        cout << "  --socket:   Socket fuer daemon/submit/subscribe (default: b15link_<board>.sock)" << endl;
+        cout << "  --channel:  Nur mit submit: virtueller Kanal 0-7, 0 = hoechste Prioritaet (default: 0)" << endl;
+        cout << "  --raw:      Nur mit receive: Nutzdaten unveraendert auf stdout, Meldungen auf stderr" << endl;
         cout << "\nBeispiel (Half-Duplex):" << endl;
         cout << "  Terminal 1: " << argv[0] << " A send" << endl;
         cout << "  Terminal 2: " << argv[0] << " B receive 20" << endl;
@@ -20,16 +59,192 @@ int main(int argc, char *argv[])
         cout << "  Terminal 1: " << argv[0] << " A fullduplex" << endl;
         cout << "  Terminal 2: " << argv[0] << " B fullduplex 20" << endl;
         cout << "               (20% Fehlerrate zum Testen)" << endl;
+        cout << "\nBeispiel (Pipeline):" << endl;
+        cout << "  tar c daten | " << argv[0] << " A send" << endl;
+        cout << "  " << argv[0] << " B receive --raw | tar x" << endl;
+        cout << "\nBeispiel (Daemon):" << endl;
+        cout << "  " << argv[0] << " A daemon    und    " << argv[0] << " B daemon" << endl;
+        cout << "  echo hallo | " << argv[0] << " A submit" << endl;
+        cout << "  " << argv[0] << " A submit --channel=7 < gross.txt   (wird von Kanal 0 ueberholt)" << endl;
+        cout << "  " << argv[0] << " B subscribe" << endl;
+        cout << "\nBeispiel (Handshake-Fehler):" << endl;
+        cout << "  " << argv[0] << " B receive --fault=glitch:clock:0.001 --fault=delay:ack:3" << endl;
         return 1;
     }
 
     char board = argv[1][0];
     string mode = argv[2];
-    int error_rate = 0;
+    double error_rate = 0;
+    vector<WireFault> wire_faults;
+    FaultScenario scenario;
+    string stats_prefix;
+    double stats_interval_s = 5;
+    string trace_path;
+    int dashboard_ms = 0;
+    string file_path;
+    WriterSettings writer_settings;
+    SpillSettings spill_settings;
+    FlowSettings flow_settings;
+    bool raw = false;
+    string socket_path;
+    int channel = 0;
 
-    if (argc >= 4)
+    for (int i = 3; i < argc; i++)
     {
-        error_rate = atoi(argv[3]);
+        string arg = argv[i];
+
+        if (arg.compare(0, 8, "--fault=") == 0)
+        {
+            WireFault fault;
+            if (!parse_wire_fault(arg.substr(8), fault))
+            {
+                cerr << "Ungueltige Fault-Spezifikation: " << arg << endl;
+                return 1;
+            }
+            wire_faults.push_back(fault);
+            continue;
+        }
+
+        if (arg.compare(0, 11, "--scenario=") == 0)
+        {
+            string error;
+            if (!scenario.load(arg.substr(11), error))
+            {
+                cerr << error << endl;
+                return 1;
+            }
+            continue;
+        }
+
+        if (arg.compare(0, 8, "--trace=") == 0)
+        {
+            trace_path = arg.substr(8);
+            continue;
+        }
+
+        if (arg.compare(0, 6, "--log=") == 0)
+        {
+            int level;
+            if (!parse_log_level(arg.substr(6), level))
+            {
+                cerr << "Unbekannte Log-Stufe: " << arg.substr(6) << endl;
+                return 1;
+            }
+            AsyncLogger::instance().set_level(level);
+            continue;
+        }
+
+        if (arg == "--dashboard" || arg.compare(0, 12, "--dashboard=") == 0)
+        {
+            dashboard_ms = arg.size() > 12 ? atoi(arg.c_str() + 12) : 250;
+            if (dashboard_ms <= 0)
+            {
+                cerr << "Dashboard-Intervall muss groesser als 0 sein!" << endl;
+                return 1;
+            }
+            continue;
+        }
+
+        if (arg == "--perf" || arg.compare(0, 7, "--perf=") == 0)
+        {
+            if (!perf_init(arg.size() > 7 ? arg.substr(7) : "all"))
+            {
+                cerr << "Unbekannte Perf-Region: " << arg.substr(7) << endl;
+                return 1;
+            }
+            continue;
+        }
+
+        if (arg.compare(0, 7, "--file=") == 0)
+        {
+            file_path = arg.substr(7);
+            continue;
+        }
+
+        if (arg.compare(0, 8, "--fsync=") == 0)
+        {
+            if (!parse_fsync_policy(arg.substr(8), writer_settings.fsync_policy))
+            {
+                cerr << "Unbekannte fsync-Policy: " << arg.substr(8) << endl;
+                return 1;
+            }
+            continue;
+        }
+
+        if (arg.compare(0, 9, "--socket=") == 0)
+        {
+            socket_path = arg.substr(9);
+            continue;
+        }
+
+        if (arg.compare(0, 10, "--channel=") == 0)
+        {
+            channel = atoi(arg.c_str() + 10);
+            if (channel < 0 || channel >= MAX_CHANNELS)
+            {
+                cerr << "Kanal muss zwischen 0 und " << MAX_CHANNELS - 1 << " sein!" << endl;
+                return 1;
+            }
+            continue;
+        }
+
+        if (arg == "--raw")
+        {
+            raw = true;
+            continue;
+        }
+
+        if (arg.compare(0, 14, "--max-message=") == 0)
+        {
+            if (!parse_byte_size(arg.substr(14), spill_settings.memory_limit))
+            {
+                cerr << "Ungueltige Groesse: " << arg.substr(14) << endl;
+                return 1;
+            }
+            continue;
+        }
+
+        if (arg.compare(0, 12, "--rx-window=") == 0)
+        {
+            if (!parse_byte_size(arg.substr(12), flow_settings.rx_window))
+            {
+                cerr << "Ungueltige Groesse: " << arg.substr(12) << endl;
+                return 1;
+            }
+            continue;
+        }
+
+        if (arg.compare(0, 12, "--spill-dir=") == 0)
+        {
+            spill_settings.directory = arg.substr(12);
+            continue;
+        }
+
+        if (arg.compare(0, 12, "--stats-out=") == 0)
+        {
+            stats_prefix = arg.substr(12);
+            continue;
+        }
+
+        if (arg.compare(0, 17, "--stats-interval=") == 0)
+        {
+            stats_interval_s = atof(arg.c_str() + 17);
+            if (stats_interval_s <= 0)
+            {
+                cerr << "Export-Intervall muss groesser als 0 sein!" << endl;
+                return 1;
+            }
+            continue;
+        }
+
+        // Tippfehler in Optionen nicht still als Fehlerrate 0 übernehmen
+        char *end = nullptr;
+        error_rate = strtod(argv[i], &end);
+        if (arg.compare(0, 2, "--") == 0 || end == argv[i] || *end != '\0')
+        {
+            cerr << "Unbekannte Option: " << arg << " (ohne Argumente aufrufen fuer die Hilfe)" << endl;
+            return 1;
+        }
         if (error_rate < 0 || error_rate > 100)
         {
             cerr << "Fehlerrate muss zwischen 0 und 100 sein!" << endl;
@@ -43,10 +258,52 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    if (mode == "send-file" && file_path.empty())
+    {
+        cerr << "send-file braucht --file=<pfad>!" << endl;
+        return 1;
+    }
+
+    if (raw && mode != "receive")
+    {
+        cerr << "--raw gibt es nur fuer receive!" << endl;
+        return 1;
+    }
+
+    if (socket_path.empty())
+    {
+        socket_path = default_daemon_socket(string(1, board));
+    }
+
+    // Clients brauchen kein eigenes Board, der Daemon hält den Link
+    if (mode == "submit")
+    {
+        return run_daemon_submit(socket_path, channel);
+    }
+    if (mode == "subscribe")
+    {
+        return run_daemon_subscribe(socket_path);
+    }
+
+    if (raw)
+    {
+        // stdout gehört ab hier allein den Nutzdaten, alle Meldungen auf stderr
+        AsyncLogger::instance().set_sink(&cerr);
+        cout.rdbuf(cerr.rdbuf());
+#ifndef _WIN32
+        // Geschlossene Pipe (z.B. "| head") als Schreibfehler melden statt abzubrechen
+        signal(SIGPIPE, SIG_IGN);
+#endif
+    }
+
     bool is_a = (board == 'A');
 
+    trace_init(trace_path.empty() ? string("trace_") + board + ".bin" : trace_path);
+    trace_thread_name(string("Board ") + board);
+
     cout << "B15F Simulator mit Checksumme & ARQ" << endl;
-    cout << "Board " << board << " - " << (mode == "send" ? "SENDER    " : "EMPFAENGER") << endl;
+    const char *role = mode == "send" || mode == "send-file" ? "SENDER    " : mode == "daemon" ? "DAEMON    " : "EMPFAENGER";
+    cout << "Board " << board << " - " << role << endl;
     if (error_rate > 0)
     {
         cout << "Fehlerrate: " << error_rate << "%" << endl;
@@ -57,12 +314,79 @@ int main(int argc, char *argv[])
         error_injector.set_error_rate(error_rate);
     }
 
-    B15Simulator board_sim(is_a, false);
+    // Socket vor dem Board: ein zweiter Daemon darf das Kabel nicht anfassen
+    unique_ptr<LinkDaemon> daemon;
+    if (mode == "daemon")
+    {
+        daemon.reset(new LinkDaemon(socket_path));
+        string error;
+        if (!daemon->start(error))
+        {
+            cerr << error << endl;
+            return 1;
+        }
+        cout << "Daemon-Socket: " << socket_path << endl;
+    }
+
+    B15Simulator board_sim(is_a, AsyncLogger::instance().enabled(LOG_LEVEL_TRACE));
+    board_sim.set_writer_settings(writer_settings);
+    board_sim.set_spill_settings(spill_settings);
+    board_sim.set_flow_settings(flow_settings);
+
+    for (size_t i = 0; i < wire_faults.size(); i++)
+    {
+        board_sim.incoming_wire_faults().add(wire_faults[i]);
+    }
+    if (!wire_faults.empty())
+    {
+        cout << "Leitungsfehler aktiv: " << wire_faults.size() << endl;
+    }
+
+    if (!scenario.empty())
+    {
+        scenario.start();
+        board_sim.set_fault_scenario(&scenario);
+    }
+
+    // Empfänger laufen endlos, daher periodisch statt nur am Ende exportieren
+    unique_ptr<StatsExporter> exporter;
+    if (!stats_prefix.empty())
+    {
+        exporter.reset(new StatsExporter(board_sim.get_stats(), stats_prefix, string(1, board)));
+        exporter->start((int)(stats_interval_s * 1000));
+        cout << "Statistik-Export: " << stats_prefix << ".{json,csv,prom}" << endl;
+    }
+
+    unique_ptr<Dashboard> dashboard;
+    if (dashboard_ms > 0)
+    {
+        dashboard.reset(new Dashboard(board_sim.get_stats(), string(1, board)));
+
+        // Bei umgeleiteter Eingabedatei ist die Gesamtgröße bekannt -> ETA
+        struct stat st;
+        if (mode == "send" && fstat(0, &st) == 0 && S_ISREG(st.st_mode))
+        {
+            dashboard->set_total_bytes((uint64_t)st.st_size);
+        }
+        else if (mode == "send-file" && stat(file_path.c_str(), &st) == 0)
+        {
+            dashboard->set_total_bytes((uint64_t)st.st_size);
+        }
+        dashboard->start(dashboard_ms);
+    }
 
     if (mode == "send")
     {
         board_sim.run_sender_mode();
     }
+    else if (mode == "send-file")
+    {
+        board_sim.run_send_file_mode(file_path);
+    }
+    else if (mode == "receive" && raw)
+    {
+        board_sim.run_raw_receiver_mode();
+    }
     else if (mode == "receive")
     {
         board_sim.run_receiver_mode();
@@ -71,11 +395,16 @@ int main(int argc, char *argv[])
     {
         board_sim.run_fullduplex_mode();
     }
+    else if (mode == "daemon")
+    {
+        board_sim.run_daemon_mode(*daemon);
+    }
     else
     {
-        cerr << "Mode muss 'send', 'receive' oder 'fullduplex' sein!" << endl;
+        cerr << "Mode muss 'send', 'send-file', 'receive', 'fullduplex', 'daemon', 'submit' oder 'subscribe' sein!" << endl;
         return 1;
     }
 
+    perf_print();
     return 0;
 }
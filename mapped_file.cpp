@@ -0,0 +1,132 @@
+#include "mapped_file.h"
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+MappedFile::MappedFile() : bytes(nullptr), length(0)
+{
+#ifdef _WIN32
+    mapping = nullptr;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    unmap();
+}
+
+void MappedFile::unmap()
+{
+#ifdef _WIN32
+    if (bytes)
+        UnmapViewOfFile(bytes);
+    if (mapping)
+        CloseHandle((HANDLE)mapping);
+    mapping = nullptr;
+#else
+    if (bytes)
+        munmap((void *)bytes, length);
+#endif
+    bytes = nullptr;
+    length = 0;
+}
+
+#ifdef _WIN32
+bool MappedFile::load(const string &path, string &error)
+{
+    unmap();
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        error = "Datei nicht lesbar: " + path;
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        error = "Dateigroesse unbekannt: " + path;
+        return false;
+    }
+
+    // Leere Datei: nichts einzublenden, CreateFileMapping würde scheitern
+    if (size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return true;
+    }
+
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file); // Das Mapping hält die Datei selbst offen
+    if (!mapping)
+    {
+        error = "CreateFileMapping fehlgeschlagen: " + path;
+        return false;
+    }
+
+    bytes = (const uint8_t *)MapViewOfFile((HANDLE)mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!bytes)
+    {
+        unmap();
+        error = "MapViewOfFile fehlgeschlagen: " + path;
+        return false;
+    }
+    length = (size_t)size.QuadPart;
+    return true;
+}
+#else
+bool MappedFile::load(const string &path, string &error)
+{
+    unmap();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        error = "Datei nicht lesbar: " + path + " (" + strerror(errno) + ")";
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        close(fd);
+        error = "Keine regulaere Datei: " + path;
+        return false;
+    }
+
+    // Leere Datei: mmap mit Länge 0 ist ungültig
+    if (st.st_size == 0)
+    {
+        close(fd);
+        return true;
+    }
+
+    void *addr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // Das Mapping hält die Datei selbst offen
+    if (addr == MAP_FAILED)
+    {
+        error = "mmap fehlgeschlagen: " + path + " (" + strerror(errno) + ")";
+        return false;
+    }
+
+    // Nur ein Hinweis an den Kernel, ein Fehler hier ist egal
+    madvise(addr, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    bytes = (const uint8_t *)addr;
+    length = (size_t)st.st_size;
+    return true;
+}
+#endif
@@ -0,0 +1,152 @@
+#include "message_arena.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+
+using namespace std;
+
+bool parse_byte_size(const string &text, size_t &bytes)
+{
+    // strtoull nähme auch Leerzeichen und ein Vorzeichen, "-1" würde riesig
+    if (text.empty() || text[0] < '0' || text[0] > '9')
+        return false;
+
+    char *end;
+    errno = 0;
+    unsigned long long value = strtoull(text.c_str(), &end, 10);
+    if (errno == ERANGE)
+        return false;
+
+    string suffix(end);
+    int shift = 0;
+    if (suffix == "K" || suffix == "k")
+        shift = 10;
+    else if (suffix == "M" || suffix == "m")
+        shift = 20;
+    else if (suffix == "G" || suffix == "g")
+        shift = 30;
+    else if (!suffix.empty())
+        return false;
+
+    if (value > (SIZE_MAX >> shift))
+        return false;
+
+    bytes = (size_t)value << shift;
+    return true;
+}
+
+static const size_t INITIAL_CAPACITY = 4096;
+
+MessageArena::MessageArena(const SpillSettings &s, const string &t)
+    : settings(s), tag(t), length(0), spilling(false), spill(nullptr), spilled_bytes(0),
+      dropped_bytes(0)
+{
+    size_t capacity = INITIAL_CAPACITY;
+    if (settings.memory_limit > 0 && settings.memory_limit < capacity)
+        capacity = settings.memory_limit;
+    buffer.resize(capacity > 0 ? capacity : 1);
+}
+
+MessageArena::~MessageArena()
+{
+    if (spill)
+    {
+        fclose(spill);
+        remove(spill_path.c_str());
+    }
+}
+
+// Puffer voll: bis zum Limit wachsen, danach auslagern
+void MessageArena::make_room()
+{
+    size_t limit = settings.memory_limit;
+    if (!spilling && (limit == 0 || buffer.size() < limit))
+    {
+        size_t capacity = buffer.size() * 2;
+        if (limit > 0 && capacity > limit)
+            capacity = limit;
+        buffer.resize(capacity);
+        return;
+    }
+
+    if (!spilling)
+    {
+        // Zeitstempel im Namen, damit ein Neustart keine Dateien eines
+        // früheren Laufs überschreibt, die noch niemand abgeholt hat
+        static atomic<unsigned> counter(0);
+        spill_path = settings.directory + "/spill_" + tag + "_" + to_string((long long)time(nullptr)) +
+                     "_" + to_string(counter++) + ".bin";
+        spill = fopen(spill_path.c_str(), "wb");
+        if (!spill)
+        {
+            cerr << "[SPILL] " << spill_path << " nicht schreibbar (" << strerror(errno)
+                 << "), Rest der Nachricht wird verworfen" << endl;
+        }
+        spilling = true;
+    }
+
+    write_spill();
+}
+
+void MessageArena::write_spill()
+{
+    if (spill && fwrite(buffer.data(), 1, length, spill) == length)
+    {
+        spilled_bytes += length;
+    }
+    else
+    {
+        dropped_bytes += length;
+    }
+    length = 0;
+}
+
+SpillFile MessageArena::take_spill()
+{
+    SpillFile file;
+    write_spill();
+
+    if (spill && fclose(spill) != 0)
+    {
+        dropped_bytes += spilled_bytes;
+        spilled_bytes = 0;
+    }
+    spill = nullptr;
+
+    file.path = spill_path;
+    file.size = spilled_bytes;
+    file.dropped = dropped_bytes;
+    return file;
+}
+
+ByteSpan MessageArena::take_message(string &note)
+{
+    if (!spilling)
+        return view();
+
+    SpillFile file = take_spill();
+    note = "[ausgelagert: " + file.path + ", " + to_string((unsigned long long)file.size) + " Bytes";
+    if (file.dropped > 0)
+        note += ", " + to_string((unsigned long long)file.dropped) + " verworfen";
+    note += "]";
+    return ByteSpan((const uint8_t *)note.data(), note.size());
+}
+
+void MessageArena::reset()
+{
+    if (spill)
+    {
+        // Nicht abgeholt, z.B. Nachricht abgebrochen
+        fclose(spill);
+        remove(spill_path.c_str());
+        spill = nullptr;
+    }
+    spilling = false;
+    spilled_bytes = 0;
+    dropped_bytes = 0;
+    length = 0;
+}
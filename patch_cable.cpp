@@ -48,26 +48,61 @@ uint8_t PatchCableFile::read()
     return value;
 }
 
-void PatchCableFile::write_bits_a(uint8_t data)
+void PatchCable::write_bits_a(uint8_t data)
 {
     uint8_t current = read();
     uint8_t new_val = (current & 0x0F) | ((data & 0x0F) << 4);
     write(new_val);
 }
 
-void PatchCableFile::write_bits_b(uint8_t data)
+void PatchCable::write_bits_b(uint8_t data)
 {
     uint8_t current = read();
     uint8_t new_val = (current & 0xF0) | (data & 0x0F);
     write(new_val);
 }
 
-uint8_t PatchCableFile::read_bits_a()
+uint8_t PatchCable::read_bits_a()
 {
-    return (read() >> 4) & 0x0F;
+    return faults_a.apply((read() >> 4) & 0x0F);
 }
 
-uint8_t PatchCableFile::read_bits_b()
+uint8_t PatchCable::read_bits_b()
 {
-    return read() & 0x0F;
+    return faults_b.apply(read() & 0x0F);
+}
+
+WireFaultModel &PatchCable::wire_faults_a()
+{
+    return faults_a;
+}
+
+WireFaultModel &PatchCable::wire_faults_b()
+{
+    return faults_b;
+}
+
+PatchCableMemory::PatchCableMemory() : bits_a(0), bits_b(0)
+{
+}
+
+void PatchCableMemory::write(uint8_t value)
+{
+    bits_a.store((value >> 4) & 0x0F);
+    bits_b.store(value & 0x0F);
+}
+
+uint8_t PatchCableMemory::read()
+{
+    return (bits_a.load() << 4) | bits_b.load();
+}
+
+void PatchCableMemory::write_bits_a(uint8_t data)
+{
+    bits_a.store(data & 0x0F);
+}
+
+void PatchCableMemory::write_bits_b(uint8_t data)
+{
+    bits_b.store(data & 0x0F);
 }
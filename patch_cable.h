@@ -1,11 +1,36 @@
 #ifndef PATCH_CABLE_H
 #define PATCH_CABLE_H
 
+#include "wire_faults.h"
+#include <atomic>
 #include <string>
 #include <cstdint>
 
+// Gemeinsame Basis für alle Patchkabel-Backends.
+// Bits 4-7 werden von Board A getrieben, Bits 0-3 von Board B.
+class PatchCable
+{
+protected:
+    WireFaultModel faults_a; // Fehler auf den Leitungen von Board A
+    WireFaultModel faults_b; // Fehler auf den Leitungen von Board B
+
+public:
+    virtual ~PatchCable() {}
+
+    virtual void write(uint8_t value) = 0;
+    virtual uint8_t read() = 0;
+
+    virtual void write_bits_a(uint8_t data);
+    virtual void write_bits_b(uint8_t data);
+    uint8_t read_bits_a();
+    uint8_t read_bits_b();
+
+    WireFaultModel &wire_faults_a();
+    WireFaultModel &wire_faults_b();
+};
+
 // Simuliertes Patchkabel als Datei
-class PatchCableFile
+class PatchCableFile : public PatchCable
 {
 private:
     std::string filename;
@@ -16,11 +41,24 @@ public:
 
     void write(uint8_t value);
     uint8_t read();
+};
+
+// Patchkabel im Speicher für mehrere Links in einem Prozess.
+// Beide Hälften sind getrennt atomar, damit A und B ohne Lock schreiben können.
+class PatchCableMemory : public PatchCable
+{
+private:
+    std::atomic<uint8_t> bits_a; // Von Board A getrieben (Bits 4-7)
+    std::atomic<uint8_t> bits_b; // Von Board B getrieben (Bits 0-3)
+
+public:
+    PatchCableMemory();
+
+    void write(uint8_t value);
+    uint8_t read();
 
     void write_bits_a(uint8_t data);
     void write_bits_b(uint8_t data);
-    uint8_t read_bits_a();
-    uint8_t read_bits_b();
 };
 
 #endif // PATCH_CABLE_H
@@ -0,0 +1,291 @@
+#include "perf_counters.h"
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#ifdef __linux__
+#include <fstream>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+static const char *const REGION_NAMES[PERF_REGIONS] = {
+    "Symbol senden", "Symbol empfangen", "Byte senden", "Byte empfangen"};
+
+static const char *const COUNTER_NAMES[PERF_COUNTERS] = {
+    "Zyklen", "Instr.", "Ctx-Wechsel", "Syscalls", "Page Faults"};
+
+static bool region_enabled[PERF_REGIONS];
+static atomic<bool> any_enabled(false);
+static atomic<bool> warned(false);
+
+static atomic<uint64_t> totals[PERF_REGIONS][PERF_COUNTERS];
+static atomic<uint64_t> calls[PERF_REGIONS];
+static atomic<bool> available[PERF_COUNTERS]; // Von mindestens einem Thread geöffnet
+
+// Zählergruppe eines Threads
+struct ThreadCounters
+{
+    bool opened = false;
+    int leader = -1;
+    int fds[PERF_COUNTERS];
+    PerfCounter order[PERF_COUNTERS]; // Reihenfolge der Werte beim Gruppen-read()
+    int count = 0;
+    uint64_t reads = 0;
+
+    ~ThreadCounters()
+    {
+#ifdef __linux__
+        for (int i = 0; i < count; i++)
+            close(fds[i]);
+#endif
+    }
+};
+
+static thread_local ThreadCounters local_counters;
+
+bool perf_init(const string &regions)
+{
+    bool selected[PERF_REGIONS] = {};
+    stringstream ss(regions.empty() ? "all" : regions);
+    string name;
+    while (getline(ss, name, ','))
+    {
+        if (name == "symbol" || name == "all")
+            selected[PERF_REGION_SYMBOL_TX] = selected[PERF_REGION_SYMBOL_RX] = true;
+        if (name == "byte" || name == "all")
+            selected[PERF_REGION_BYTE_TX] = selected[PERF_REGION_BYTE_RX] = true;
+        if (name != "symbol" && name != "byte" && name != "all")
+            return false;
+    }
+
+#ifdef __linux__
+    for (int r = 0; r < PERF_REGIONS; r++)
+        region_enabled[r] = selected[r];
+    any_enabled = true;
+#else
+    cerr << "[PERF] perf_event_open gibt es nur unter Linux, Zaehler deaktiviert" << endl;
+#endif
+    return true;
+}
+
+bool perf_enabled(PerfRegion region)
+{
+    return any_enabled.load(memory_order_relaxed) && region_enabled[region];
+}
+
+#ifdef __linux__
+// Nummer des Tracepoints raw_syscalls:sys_enter, -1 ohne tracefs-Zugriff
+static int syscall_tracepoint_id()
+{
+    static const char *const paths[] = {
+        "/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+        "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id"};
+
+    for (const char *path : paths)
+    {
+        ifstream in(path);
+        int id;
+        if (in >> id)
+            return id;
+    }
+    return -1;
+}
+
+static int open_counter(PerfCounter counter, int group_fd)
+{
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.exclude_hv = 1;
+
+    switch (counter)
+    {
+    case PERF_CYCLES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case PERF_INSTRUCTIONS:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case PERF_CONTEXT_SWITCHES:
+        attr.type = PERF_TYPE_SOFTWARE;
+        attr.config = PERF_COUNT_SW_CONTEXT_SWITCHES;
+        break;
+    case PERF_SYSCALLS:
+    {
+        int id = syscall_tracepoint_id();
+        if (id < 0)
+        {
+            errno = ENOENT;
+            return -1;
+        }
+        attr.type = PERF_TYPE_TRACEPOINT;
+        attr.config = id;
+        break;
+    }
+    case PERF_PAGE_FAULTS:
+        attr.type = PERF_TYPE_SOFTWARE;
+        attr.config = PERF_COUNT_SW_PAGE_FAULTS;
+        break;
+    default:
+        return -1;
+    }
+
+    // Nur diesen Thread, beliebige CPU
+    int fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+    if (fd < 0 && (errno == EACCES || errno == EPERM))
+    {
+        // perf_event_paranoid >= 2: nur User-Space darf gezählt werden
+        attr.exclude_kernel = 1;
+        fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+    }
+    return fd;
+}
+
+static void open_thread_counters(ThreadCounters &tc)
+{
+    tc.opened = true;
+
+    int first_error = 0;
+    for (int c = 0; c < PERF_COUNTERS; c++)
+    {
+        int fd = open_counter((PerfCounter)c, tc.leader);
+        if (fd < 0)
+        {
+            if (!first_error)
+                first_error = errno;
+            continue;
+        }
+
+        if (tc.leader < 0)
+            tc.leader = fd;
+        tc.fds[tc.count] = fd;
+        tc.order[tc.count] = (PerfCounter)c;
+        tc.count++;
+        available[c] = true;
+    }
+
+    if (tc.count == 0 && !warned.exchange(true))
+    {
+        cerr << "[PERF] perf_event_open nicht verfuegbar (" << strerror(first_error)
+             << "), Zaehler deaktiviert" << endl;
+    }
+}
+
+static void read_counters(ThreadCounters &tc, uint64_t values[PERF_COUNTERS])
+{
+    // PERF_FORMAT_GROUP: Anzahl, dann ein Wert pro Zähler in Öffnungsreihenfolge
+    uint64_t buf[1 + PERF_COUNTERS];
+    ssize_t n = read(tc.leader, buf, sizeof(buf));
+    tc.reads++;
+
+    for (int i = 0; i < tc.count; i++)
+    {
+        values[tc.order[i]] = (n > 0 && (uint64_t)i < buf[0]) ? buf[1 + i] : 0;
+    }
+}
+#endif
+
+PerfScope::PerfScope(PerfRegion r) : region(r), active(false), reads_at_start(0)
+{
+#ifdef __linux__
+    if (!perf_enabled(region))
+        return;
+
+    ThreadCounters &tc = local_counters;
+    if (!tc.opened)
+        open_thread_counters(tc);
+    if (tc.count == 0)
+        return;
+
+    active = true;
+    read_counters(tc, start);
+    reads_at_start = tc.reads;
+#endif
+}
+
+PerfScope::~PerfScope()
+{
+#ifdef __linux__
+    if (!active)
+        return;
+
+    ThreadCounters &tc = local_counters;
+    uint64_t end[PERF_COUNTERS];
+    read_counters(tc, end);
+
+    for (int i = 0; i < tc.count; i++)
+    {
+        PerfCounter c = tc.order[i];
+        uint64_t delta = end[c] - start[c];
+
+        // Eigene read()-Aufrufe dazwischen (verschachtelte Regionen und das
+        // abschließende read) nicht mitzählen
+        if (c == PERF_SYSCALLS)
+        {
+            uint64_t own = tc.reads - reads_at_start;
+            delta = delta > own ? delta - own : 0;
+        }
+        totals[region][c].fetch_add(delta, memory_order_relaxed);
+    }
+    calls[region].fetch_add(1, memory_order_relaxed);
+#endif
+}
+
+void perf_print()
+{
+    if (!any_enabled)
+        return;
+
+    bool any_calls = false;
+    for (int r = 0; r < PERF_REGIONS; r++)
+        any_calls = any_calls || calls[r] > 0;
+    if (!any_calls)
+        return;
+
+    ios::fmtflags flags = cout.flags();
+    streamsize precision = cout.precision();
+
+    cout << "Performance-Zaehler (Mittel pro Aufruf):" << endl;
+    cout << "  " << left << setw(18) << "Region" << right << setw(10) << "Aufrufe";
+    for (int c = 0; c < PERF_COUNTERS; c++)
+        cout << setw(13) << COUNTER_NAMES[c];
+    cout << setw(7) << "IPC" << endl;
+
+    cout << fixed << setprecision(1);
+    for (int r = 0; r < PERF_REGIONS; r++)
+    {
+        uint64_t n = calls[r];
+        if (n == 0)
+            continue;
+
+        cout << "  " << left << setw(18) << REGION_NAMES[r] << right << setw(10) << n;
+        for (int c = 0; c < PERF_COUNTERS; c++)
+        {
+            if (available[c])
+                cout << setw(13) << (double)totals[r][c] / n;
+            else
+                cout << setw(13) << "n/a";
+        }
+
+        uint64_t cycles = totals[r][PERF_CYCLES];
+        if (available[PERF_CYCLES] && available[PERF_INSTRUCTIONS] && cycles > 0)
+            cout << setw(7) << setprecision(2) << (double)totals[r][PERF_INSTRUCTIONS] / cycles
+                 << setprecision(1);
+        else
+            cout << setw(7) << "n/a";
+        cout << endl;
+    }
+    cout << "  (Byte-Regionen enthalten die Messkosten der Symbol-Regionen, falls beide aktiv)" << endl;
+
+    cout.flags(flags);
+    cout.precision(precision);
+}
@@ -0,0 +1,61 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Hardware- und Software-Zähler (perf_event_open, nur Linux) um Abschnitte
+// des Protokolls. Zeigt, ob send_2bits/receive_2bits an Syscalls hängen (z.B.
+// PatchCableFile öffnet die Datei bei jedem Poll) oder an Cache/CPU.
+//
+// Opt-in über perf_init(). Ohne Aufruf, auf anderen Systemen oder wenn der
+// Kernel die Zähler verweigert (perf_event_paranoid, Container, VM ohne PMU)
+// sind alle Regionen leere Operationen. Einzelne fehlende Zähler werden als
+// "n/a" ausgewiesen, die übrigen laufen weiter.
+
+enum PerfRegion
+{
+    PERF_REGION_SYMBOL_TX = 0, // send_2bits
+    PERF_REGION_SYMBOL_RX,     // receive_2bits
+    PERF_REGION_BYTE_TX,       // send_byte_with_checksum inkl. ACK
+    PERF_REGION_BYTE_RX,       // receive_byte_with_checksum inkl. ACK
+    PERF_REGIONS
+};
+
+enum PerfCounter
+{
+    PERF_CYCLES = 0,
+    PERF_INSTRUCTIONS,
+    PERF_CONTEXT_SWITCHES,
+    PERF_SYSCALLS,
+    PERF_PAGE_FAULTS,
+    PERF_COUNTERS
+};
+
+// Regionen als Komma-Liste: "symbol", "byte" oder "all" (default).
+// false bei unbekanntem Namen.
+bool perf_init(const std::string &regions);
+
+bool perf_enabled(PerfRegion region);
+
+// Ergebnis als Tabelle (Mittelwerte pro Aufruf) auf stdout
+void perf_print();
+
+// Misst einen Abschnitt auf dem aufrufenden Thread. Jeder Thread öffnet
+// beim ersten Mal eine eigene Zählergruppe; Anfang und Ende kosten je einen
+// read()-Aufruf, der aus der Syscall-Zahl wieder herausgerechnet wird.
+class PerfScope
+{
+public:
+    explicit PerfScope(PerfRegion region);
+    ~PerfScope();
+
+private:
+    PerfRegion region;
+    bool active;
+    uint64_t reads_at_start;
+    uint64_t start[PERF_COUNTERS];
+};
+
+#endif // PERF_COUNTERS_H
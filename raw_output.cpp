@@ -0,0 +1,117 @@
+#include "raw_output.h"
+#include <cerrno>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Höchstens so viel pro write()-Aufruf; ohne flush() wird erst ab einem
+// vollen Block geschrieben oder wenn Daten FLUSH_INTERVAL liegen. Sonst käme
+// ein Sender, der auf Credit wartet, mitten in einer Nachricht nie weiter.
+static const size_t BLOCK_SIZE = 64 * 1024;
+static const chrono::milliseconds FLUSH_INTERVAL(100);
+
+RawOutput::RawOutput(int f, size_t capacity)
+    : fd(f), ring(capacity > 0 ? capacity : 1), flush_requested(false), closing(false), failed(false)
+{
+#ifdef _WIN32
+    _setmode(fd, _O_BINARY);
+#endif
+    writer = thread(&RawOutput::run, this);
+}
+
+RawOutput::~RawOutput()
+{
+    closing.store(true, memory_order_release);
+    data_ready.notify();
+    flush_due.notify();
+    writer.join();
+}
+
+void RawOutput::write(const uint8_t *data, size_t len)
+{
+    size_t done = 0;
+    while (ok())
+    {
+        done += ring.push(data + done, len - done);
+        data_ready.notify();
+        if (ring.size() >= BLOCK_SIZE)
+            flush_due.notify();
+
+        if (done == len)
+            break;
+        wait_for_room();
+    }
+}
+
+void RawOutput::flush()
+{
+    flush_requested.store(true, memory_order_release);
+    data_ready.notify();
+    flush_due.notify();
+}
+
+void RawOutput::run()
+{
+    vector<uint8_t> block(BLOCK_SIZE);
+    for (;;)
+    {
+        // Ohne Daten schlafen, bis write(), flush() oder der Destruktor weckt
+        data_ready.wait([&]()
+                        { return ring.size() > 0 || flush_requested.load() || closing.load(); });
+
+        // Ab den ersten Daten höchstens FLUSH_INTERVAL sammeln
+        flush_due.wait_until(chrono::steady_clock::now() + FLUSH_INTERVAL, [&]()
+                             { return ring.size() >= BLOCK_SIZE || flush_requested.load() || closing.load(); });
+
+        // closing vor dem Leeren lesen: alles davor Geschriebene ist dann im Ring
+        bool last = closing.load(memory_order_acquire);
+        flush_requested.store(false, memory_order_release);
+
+        size_t n;
+        while ((n = ring.pop(block.data(), block.size())) > 0)
+        {
+            write_all(block.data(), n);
+            space_ready.notify();
+        }
+        if (last)
+        {
+            break;
+        }
+    }
+}
+
+void RawOutput::write_all(const uint8_t *data, size_t len)
+{
+    // Nach einem Fehler nur noch verwerfen, der Empfang läuft weiter
+    size_t done = 0;
+    while (ok() && done < len)
+    {
+#ifdef _WIN32
+        int n = _write(fd, data + done, (unsigned)(len - done));
+#else
+        ssize_t n = ::write(fd, data + done, len - done);
+#endif
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+        {
+            failed.store(true, memory_order_release);
+            break;
+        }
+        done += (size_t)n;
+    }
+}
+
+void RawOutput::wait_for_room()
+{
+    flush();
+    space_ready.wait([&]()
+                     { return !ok() || ring.size() < ring.capacity(); });
+}
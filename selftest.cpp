@@ -0,0 +1,304 @@
+// Selbsttest für Teile, die sich ohne zweites Board prüfen lassen.
+// Aufruf: selftest.exe (Exit-Code 0 = alles ok, sonst Anzahl Fehler)
+
+#include "b15simulator.h"
+#include "error_injector.h"
+#include "group_writer.h"
+#include "input_stream.h"
+#include "message_arena.h"
+#include "patch_cable.h"
+#include "protocol.h"
+#include "stats.h"
+#include "trace.h"
+#include "wire_faults.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+static int failures = 0;
+
+#define CHECK(cond, what)                                         \
+    do                                                            \
+    {                                                             \
+        if (!(cond))                                              \
+        {                                                         \
+            cerr << "FEHLER: " << what << " (" #cond ")" << endl; \
+            failures++;                                           \
+        }                                                         \
+    } while (0)
+
+// delay:<leitung>:N verdeckt jede Flanke für genau N Lesezugriffe
+static void test_delayed_edge()
+{
+    for (int duration = 1; duration <= 4; duration++)
+    {
+        WireFault fault;
+        CHECK(parse_wire_fault("delay:clock:" + to_string(duration), fault), "delay parsen");
+
+        WireFaultModel model;
+        model.add(fault);
+        CHECK(model.apply(0) == 0, "Ruhepegel");
+
+        int hidden = 0;
+        while (hidden < 10 && (model.apply(CLOCK) & CLOCK) == 0)
+        {
+            hidden++;
+        }
+        CHECK(hidden == duration, "steigende Flanke bei delay " << duration << ": " << hidden << " verdeckt");
+        CHECK((model.apply(CLOCK) & CLOCK) != 0, "Pegel bleibt nach der Flanke");
+
+        hidden = 0;
+        while (hidden < 10 && (model.apply(0) & CLOCK) != 0)
+        {
+            hidden++;
+        }
+        CHECK(hidden == duration, "fallende Flanke bei delay " << duration << ": " << hidden << " verdeckt");
+        CHECK(model.event_count() == 2, "zwei Flanken gezählt");
+    }
+}
+
+// ABORT_BYTE setzt Unstuffer und ChannelTracker auch mitten in einem ESC-
+// oder Kanalpaar zurück
+static void test_abort_resets_framing()
+{
+    Unstuffer unstuffer;
+    ChannelTracker channels;
+
+    uint8_t byte = CHANNEL_BYTE;
+    channels.feed(unstuffer.feed(byte), byte);
+    byte = 3;
+    channels.feed(unstuffer.feed(byte), byte);
+    CHECK(channels.current() == 3, "Kanal 3 aktiv");
+
+    byte = ESC_BYTE;
+    CHECK(unstuffer.feed(byte) == Unstuffer::PENDING, "ESC wartet");
+    byte = ABORT_BYTE;
+    Unstuffer::Kind kind = unstuffer.feed(byte);
+    CHECK(kind == Unstuffer::CONTROL && byte == ABORT_BYTE, "ABORT nach halbem ESC-Paar");
+    CHECK(channels.feed(kind, byte), "ABORT geht an den Aufrufer");
+    CHECK(channels.current() == 0, "nach ABORT wieder Kanal 0");
+
+    byte = 'a';
+    CHECK(unstuffer.feed(byte) == Unstuffer::PAYLOAD && byte == 'a', "ESC nach ABORT vergessen");
+
+    byte = CHANNEL_BYTE;
+    CHECK(!channels.feed(unstuffer.feed(byte), byte), "Kanalwechsel beginnt");
+    byte = ABORT_BYTE;
+    kind = unstuffer.feed(byte);
+    CHECK(channels.feed(kind, byte) && channels.current() == 0, "ABORT statt Kanalnummer");
+    byte = 'b';
+    CHECK(channels.feed(unstuffer.feed(byte), byte), "Kanalnummer nach ABORT nicht mehr erwartet");
+
+    uint8_t wire[2];
+    CHECK(stuff_byte(ABORT_BYTE, wire) == 2, "ABORT_BYTE in Nutzdaten wird maskiert");
+}
+
+// Kein NACK mit einem gekippten Bit wird als ACK gelesen, ein volles Fenster
+// meldet ACK_FULL, sonst gilt ACK_BYTE (kein Limit)
+static void test_credit_codes()
+{
+    for (int bit = 0; bit < 8; bit++)
+    {
+        uint8_t flipped = NACK_BYTE ^ (uint8_t)(1 << bit);
+        CHECK(!is_ack(flipped), "NACK mit Bit " << bit << " gekippt als ACK gelesen");
+    }
+    CHECK(credit_ack(0) == ACK_FULL && ack_credit(ACK_FULL) == 0, "volles Fenster");
+    CHECK(credit_ack(CREDIT_UNIT) == ACK_BYTE && ack_credit(ACK_BYTE) == -1, "Platz frei");
+    CHECK(FlowSettings().rx_window == 0, "Fenster ist ohne --rx-window aus");
+}
+
+// inject_errors() verfälscht einen Puffer genau wie inject_error() Byte für
+// Byte, auch wenn der Puffer in Stücken kommt
+static void test_bulk_injection()
+{
+    ErrorInjector per_byte(0), bulk(0);
+    per_byte.set_seed(42);
+    bulk.set_seed(42);
+    per_byte.set_error_rate(5);
+    bulk.set_error_rate(5);
+
+    vector<uint8_t> expected(10000, 0x55), actual(10000, 0x55);
+    size_t flipped = 0;
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        expected[i] = per_byte.inject_error(expected[i]);
+        flipped += expected[i] != 0x55;
+    }
+
+    size_t corrupted = bulk.inject_errors(actual.data(), 3333);
+    corrupted += bulk.inject_errors(actual.data() + 3333, actual.size() - 3333);
+
+    CHECK(corrupted == flipped, corrupted << " statt " << flipped << " Bytes verfaelscht");
+    CHECK(actual == expected, "gleiche Fehlerfolge wie pro Byte");
+    CHECK(flipped > 300 && flipped < 700, flipped << " Fehler bei 5% von 10000 Bytes");
+}
+
+// Vorzeichen, Überlauf und Unsinn werden abgelehnt statt umgebrochen
+static void test_parse_byte_size()
+{
+    size_t bytes = 0;
+    CHECK(parse_byte_size("65536", bytes) && bytes == 65536, "65536");
+    CHECK(parse_byte_size("512K", bytes) && bytes == 512u << 10, "512K");
+    CHECK(parse_byte_size("64m", bytes) && bytes == 64u << 20, "64m");
+    CHECK(parse_byte_size("0", bytes) && bytes == 0, "0");
+
+    const char *invalid[] = {"", "-1", "+5", " 5", "K", "5X", "5KB",
+                             "99999999999999G", "99999999999999999999"};
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+    {
+        bytes = 123;
+        CHECK(!parse_byte_size(invalid[i], bytes) && bytes == 123, "\"" << invalid[i] << "\" abgelehnt");
+    }
+}
+
+// Ringe beendeter Threads werden wiederverwendet, auch nach mehr als
+// 64 Threads bekommt ein neuer Thread noch einen
+static void test_trace_ring_reuse()
+{
+    for (int i = 0; i < 200; i++)
+    {
+        bool got_ring = false;
+        thread worker([&]()
+                      {
+            trace(TRACE_RETRY, 1);
+            got_ring = trace_local_ring != nullptr; });
+        worker.join();
+        CHECK(got_ring, "Trace-Ring fuer Thread " << i);
+    }
+}
+
+// Alle 256 Bytewerte kommen über zwei Boards an einem PatchCableMemory
+// unverändert an, auch die mit Checksum 0xFF (z.B. 0xB7)
+static void test_all_byte_values()
+{
+    PatchCableMemory cable;
+    Stats stats_a, stats_b;
+    ErrorInjector injector_a(0), injector_b(0);
+
+    B15Simulator board_a(true, cable);
+    B15Simulator board_b(false, cable);
+    board_a.set_stats(&stats_a);
+    board_b.set_stats(&stats_b);
+    board_a.set_error_injector(&injector_a);
+    board_b.set_error_injector(&injector_b);
+
+    atomic<bool> sender_done(false);
+    vector<uint8_t> received;
+
+    thread receiver([&]()
+                    {
+        Unstuffer unstuffer;
+        while (!sender_done)
+        {
+            uint8_t byte = board_b.receive_byte_with_checksum();
+            if (byte == 0xFF)
+                continue;
+            if (unstuffer.feed(byte) == Unstuffer::PAYLOAD)
+                received.push_back(byte);
+        } });
+
+    bool sent = true;
+    for (int value = 0; value < 256 && sent; value++)
+    {
+        uint8_t wire[2];
+        int len = stuff_byte((uint8_t)value, wire);
+        for (int i = 0; i < len && sent; i++)
+        {
+            sent = board_a.send_byte_with_checksum(wire[i]);
+        }
+        CHECK(sent, "Byte 0x" << hex << value << dec << " gesendet");
+    }
+
+    sender_done = true;
+    receiver.join();
+
+    CHECK(received.size() == 256, received.size() << " von 256 Bytes empfangen");
+    for (size_t i = 0; i < received.size(); i++)
+    {
+        CHECK(received[i] == i, "Byte " << i << " als 0x" << hex << (int)received[i] << dec << " empfangen");
+    }
+}
+
+// InputStream wartet ohne Pollen auf eine pausierende Pipe und wacht für
+// neue Daten und für EOF auf
+static void test_input_stream_wakeup()
+{
+#ifndef _WIN32
+    int fds[2];
+    CHECK(pipe(fds) == 0, "Pipe anlegen");
+
+    InputStream input(fds[0], 16);
+    thread writer([&]()
+                  {
+        this_thread::sleep_for(chrono::milliseconds(50));
+        CHECK(write(fds[1], "abc", 3) == 3, "erster Block");
+        this_thread::sleep_for(chrono::milliseconds(50));
+        CHECK(write(fds[1], "defghijklmnopqrstuvwxyz", 23) == 23, "mehr als der Ring fasst");
+        close(fds[1]); });
+
+    string got;
+    uint8_t block[8];
+    size_t n;
+    while ((n = input.read(block, sizeof(block))) > 0)
+    {
+        got.append((const char *)block, n);
+    }
+    writer.join();
+    close(fds[0]);
+    CHECK(got == "abcdefghijklmnopqrstuvwxyz", "Pipe-Inhalt: " << got);
+#endif
+}
+
+// Ein fehlgeschlagener Schreibversuch (hier ENOSPC von /dev/full) wird
+// gezählt, der Batch bleibt für den nächsten Versuch stehen
+static void test_writer_keeps_failed_batch()
+{
+#ifndef _WIN32
+    Stats stats;
+    WriterSettings settings;
+    settings.flush_interval_ms = 60000; // Worker soll nicht dazwischen schreiben
+    GroupCommitWriter writer(settings);
+    writer.set_stats(&stats);
+    string error;
+    CHECK(writer.open("/dev/full", error), "/dev/full oeffnen: " << error);
+
+    const uint8_t text[] = {'h', 'a', 'l', 'l', 'o'};
+    writer.append(ByteSpan(text, sizeof(text)));
+    writer.flush();
+    CHECK(stats.write_errors == 1, "Schreibfehler gezaehlt");
+    CHECK(writer.backlog() == 6, "Batch nach Fehler behalten: " << writer.backlog() << " Bytes");
+
+    writer.append(ByteSpan(text, 2));
+    writer.flush();
+    CHECK(stats.write_errors == 2, "zweiter Versuch gezaehlt");
+    CHECK(writer.backlog() == 9, "neue Nachricht hinten angehaengt: " << writer.backlog() << " Bytes");
+#endif
+}
+
+int main()
+{
+    test_delayed_edge();
+    test_abort_resets_framing();
+    test_credit_codes();
+    test_bulk_injection();
+    test_parse_byte_size();
+    test_trace_ring_reuse();
+    test_all_byte_values();
+    test_writer_keeps_failed_batch();
+    test_input_stream_wakeup();
+
+    if (failures == 0)
+    {
+        cout << "Selbsttest ok" << endl;
+    }
+    return failures;
+}
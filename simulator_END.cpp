@@ -1,3 +1,4 @@
+#include "logger.h"
 #include <iostream>
 #include <cstdint>
 #include <bitset>
@@ -82,8 +83,8 @@ public:
         {
             int bit_to_flip = rand() % 8;
             uint8_t corrupted = data ^ (1 << bit_to_flip);
-            cout << "  [ERROR!] Bit " << bit_to_flip << " geflippt: "
-                 << bitset<8>(data) << " -> " << bitset<8>(corrupted) << endl;
+            LOG_DEBUG("  [ERROR!] Bit " << bit_to_flip << " geflippt: "
+                      << bitset<8>(data) << " -> " << bitset<8>(corrupted));
             return corrupted;
         }
         return data;
@@ -193,7 +194,7 @@ private:
             cable.write_bits_a(data & 0x0F);
             if (verbose)
             {
-                cout << "  [" << name << "] -> " << bitset<4>(data & 0x0F) << endl;
+                LOG_TRACE("  [" << name << "] -> " << bitset<4>(data & 0x0F));
             }
         }
         else
@@ -201,7 +202,7 @@ private:
             cable.write_bits_b(data & 0x0F);
             if (verbose)
             {
-                cout << "  [" << name << "] -> " << bitset<4>(data & 0x0F) << endl;
+                LOG_TRACE("  [" << name << "] -> " << bitset<4>(data & 0x0F));
             }
         }
     }
@@ -338,7 +339,7 @@ public:
 
         write_output(0);
 
-        cout << "[" << name << "] Initialisiert!" << endl;
+        LOG_INFO("[" << name << "] Initialisiert!");
     }
 
     void set_verbose(bool v) { verbose = v; }
@@ -352,25 +353,25 @@ public:
         {
             if (retry > 0)
             {
-                cout << "[" << name << "] WIEDERHOLUNG " << retry << "/" << MAX_RETRIES << endl;
+                LOG_DEBUG("[" << name << "] WIEDERHOLUNG " << retry << "/" << MAX_RETRIES);
                 global_stats.retransmissions++;
             }
 
-            cout << "[" << name << "] Sende Byte: '" << (char)byte << "' (0x"
-                 << hex << (int)byte << dec << ") + Checksum: 0x"
-                 << hex << (int)checksum << dec << endl;
+            LOG_DEBUG("[" << name << "] Sende Byte: '" << (char)byte << "' (0x"
+                      << hex << (int)byte << dec << ") + Checksum: 0x"
+                      << hex << (int)checksum << dec);
 
             // Sende Daten-Byte
             if (!send_byte_raw(byte))
             {
-                cerr << "[" << name << "] Fehler beim Senden!" << endl;
+                LOG_WARN("[" << name << "] Fehler beim Senden!");
                 return false;
             }
 
             // Sende Checksum
             if (!send_byte_raw(checksum))
             {
-                cerr << "[" << name << "] Fehler beim Senden der Checksum!" << endl;
+                LOG_WARN("[" << name << "] Fehler beim Senden der Checksum!");
                 return false;
             }
 
@@ -379,34 +380,34 @@ public:
 
             if (response == ACK_BYTE)
             {
-                cout << "[" << name << "] << ACK empfangen! Byte erfolgreich uebertragen." << endl;
+                LOG_DEBUG("[" << name << "] << ACK empfangen! Byte erfolgreich uebertragen.");
                 global_stats.bytes_sent++;
                 return true;
             }
             else if (response == NACK_BYTE)
             {
-                cout << "[" << name << "] << NACK empfangen! Checksum-Fehler, wiederhole..." << endl;
+                LOG_DEBUG("[" << name << "] << NACK empfangen! Checksum-Fehler, wiederhole...");
             }
             else
             {
-                cout << "[" << name << "] << Unerwartete Antwort: 0x" << hex << (int)response << dec << endl;
+                LOG_DEBUG("[" << name << "] << Unerwartete Antwort: 0x" << hex << (int)response << dec);
             }
         }
 
-        cerr << "[" << name << "] XXX MAX RETRIES erreicht! Uebertragung fehlgeschlagen." << endl;
+        LOG_ERROR("[" << name << "] XXX MAX RETRIES erreicht! Uebertragung fehlgeschlagen.");
         return false;
     }
 
     // Empfängt Byte mit Checksumme und sendet ACK/NACK
     uint8_t receive_byte_with_checksum()
     {
-        cout << "\n[" << name << "] Warte auf Byte..." << endl;
+        LOG_TRACE("[" << name << "] Warte auf Byte...");
 
         // Empfange Daten-Byte (mit Fehler-Injektion!)
         uint8_t byte = receive_byte_raw();
         if (byte == 0xFF)
         {
-            cerr << "[" << name << "] Timeout beim Empfangen!" << endl;
+            LOG_DEBUG("[" << name << "] Timeout beim Empfangen!");
             return 0xFF;
         }
 
@@ -417,27 +418,27 @@ public:
         uint8_t received_checksum = receive_byte_raw();
         if (received_checksum == 0xFF)
         {
-            cerr << "[" << name << "] Timeout beim Empfangen der Checksum!" << endl;
+            LOG_DEBUG("[" << name << "] Timeout beim Empfangen der Checksum!");
             return 0xFF;
         }
 
         // Berechne erwartete Checksum
         uint8_t expected_checksum = calculate_checksum(received_byte);
 
-        cout << "[" << name << "] Empfangen: 0x" << hex << (int)received_byte << dec
-             << ", Checksum: 0x" << hex << (int)received_checksum << dec
-             << " (erwartet: 0x" << hex << (int)expected_checksum << dec << ")" << endl;
+        LOG_DEBUG("[" << name << "] Empfangen: 0x" << hex << (int)received_byte << dec
+                  << ", Checksum: 0x" << hex << (int)received_checksum << dec
+                  << " (erwartet: 0x" << hex << (int)expected_checksum << dec << ")");
 
         if (received_checksum == expected_checksum)
         {
-            cout << "[" << name << "] >> Checksum OK! Sende ACK." << endl;
+            LOG_DEBUG("[" << name << "] >> Checksum OK! Sende ACK.");
             send_byte_raw(ACK_BYTE);
             global_stats.bytes_received++;
             return received_byte;
         }
         else
         {
-            cout << "[" << name << "] XX Checksum FEHLER! Sende NACK." << endl;
+            LOG_DEBUG("[" << name << "] XX Checksum FEHLER! Sende NACK.");
             send_byte_raw(NACK_BYTE);
             global_stats.checksum_errors++;
             return 0xFF; // Signalisiert Fehler
@@ -453,14 +454,15 @@ public:
         string line;
         while (getline(cin, line))
         {
-            cout << "[" << name << "] Sende Nachricht: \"" << line << "\"" << endl;
+            LOG_INFO("[" << name << "] Sende Nachricht: \"" << line << "\"");
 
             // Sende alle Zeichen der Zeile
             for (char c : line)
             {
                 if (!send_byte_with_checksum(c))
                 {
-                    cerr << "[" << name << "] Uebertragung abgebrochen!" << endl;
+                    LOG_ERROR("[" << name << "] Uebertragung abgebrochen!");
+                    AsyncLogger::instance().flush();
                     global_stats.print();
                     return;
                 }
@@ -469,24 +471,26 @@ public:
             // Sende Newline
             if (!send_byte_with_checksum('\n'))
             {
-                cerr << "[" << name << "] Uebertragung abgebrochen!" << endl;
+                LOG_ERROR("[" << name << "] Uebertragung abgebrochen!");
+                AsyncLogger::instance().flush();
                 global_stats.print();
                 return;
             }
 
             // Sende EOT (End of Transmission)
-            cout << "[" << name << "] Sende EOT (End of Transmission)" << endl;
+            LOG_DEBUG("[" << name << "] Sende EOT (End of Transmission)");
             if (!send_byte_with_checksum(EOT_BYTE))
             {
-                cerr << "[" << name << "] Uebertragung abgebrochen!" << endl;
+                LOG_ERROR("[" << name << "] Uebertragung abgebrochen!");
+                AsyncLogger::instance().flush();
                 global_stats.print();
                 return;
             }
 
-            cout << "[" << name << "] >>> Nachricht komplett gesendet! <<<\n"
-                 << endl;
+            LOG_INFO("[" << name << "] >>> Nachricht komplett gesendet! <<<\n");
         }
 
+        AsyncLogger::instance().flush();
         global_stats.print();
     }
 
@@ -510,9 +514,9 @@ public:
             // Prüfe auf EOT (End of Transmission)
             if (byte == EOT_BYTE)
             {
-                cout << "[" << name << "] EOT empfangen! Nachricht komplett." << endl;
-                cout << "[" << name << "] EMPFANGENE NACHRICHT:" << endl;
-                cout << ">>> " << received_message << " <<<" << endl;
+                LOG_INFO("[" << name << "] EOT empfangen! Nachricht komplett.");
+                LOG_INFO("[" << name << "] EMPFANGENE NACHRICHT:");
+                LOG_INFO(">>> " << received_message << " <<<");
 
                 // Reset für nächste Nachricht
                 received_message = "";
@@ -521,8 +525,8 @@ public:
 
             // Sammle Zeichen
             received_message += (char)byte;
-            cout << "[" << name << "] Zeichen empfangen: '" << (char)byte
-                 << "' (Message bisher: \"" << received_message << "\")" << endl;
+            LOG_DEBUG("[" << name << "] Zeichen empfangen: '" << (char)byte
+                      << "' (Message bisher: \"" << received_message << "\")");
         }
     }
 };
@@ -0,0 +1,174 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+// Begrenzter Byte-Ring für genau einen Schreiber- und einen Leser-Thread,
+// ohne Locks und ohne Allokation nach dem Konstruktor.
+//
+// head und tail zählen frei hoch und werden erst beim Zugriff maskiert, voll
+// und leer sind damit ohne Extra-Flag unterscheidbar. Beide liegen auf
+// eigenen Cache-Lines. Jede Seite merkt sich zusätzlich den zuletzt
+// gesehenen Index der Gegenseite und liest den geteilten nur neu, wenn die
+// Kopie nicht mehr reicht; im Normalfall wandert also keine Line hin und her.
+class SpscByteRing
+{
+public:
+    // Wird auf die nächste Zweierpotenz aufgerundet
+    explicit SpscByteRing(size_t min_capacity)
+        : head(0), cached_tail(0), tail(0), cached_head(0)
+    {
+        size_t capacity = 1;
+        while (capacity < min_capacity)
+            capacity <<= 1;
+        buffer.resize(capacity);
+        mask = capacity - 1;
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+    // Belegte Bytes; von fremden Threads nur als Momentaufnahme. head zuerst:
+    // tail kann nur wachsen, mit einem älteren head bleibt das Ergebnis
+    // höchstens zu groß statt negativ (umgebrochen)
+    size_t size() const
+    {
+        size_t h = head.load(std::memory_order_acquire);
+        return tail.load(std::memory_order_acquire) - h;
+    }
+
+    // ---- Nur der Schreiber ----
+
+    // Kopiert so viel wie passt, Rückgabe = Anzahl Bytes
+    size_t push(const uint8_t *src, size_t n)
+    {
+        size_t done = 0;
+        while (done < n)
+        {
+            uint8_t *window;
+            size_t len = write_window(window);
+            if (len == 0)
+                break;
+            len = std::min(len, n - done);
+            memcpy(window, src + done, len);
+            commit_write(len);
+            done += len;
+        }
+        return done;
+    }
+
+    // Zusammenhängender freier Bereich ab tail, z.B. als Ziel für read().
+    // Rückgabe = Länge, 0 = voll. Danach commit_write() mit der tatsächlichen Menge.
+    size_t write_window(uint8_t *&window)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t free_bytes = capacity() - (t - cached_head);
+        if (free_bytes == 0)
+        {
+            cached_head = head.load(std::memory_order_acquire);
+            free_bytes = capacity() - (t - cached_head);
+        }
+
+        size_t offset = t & mask;
+        window = &buffer[offset];
+        return std::min(free_bytes, capacity() - offset);
+    }
+
+    void commit_write(size_t n)
+    {
+        tail.store(tail.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+    // ---- Nur der Leser ----
+
+    // Kopiert bis zu max Bytes, Rückgabe = Anzahl, 0 = leer
+    size_t pop(uint8_t *dst, size_t max)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t available = cached_tail - h;
+        if (available < max)
+        {
+            cached_tail = tail.load(std::memory_order_acquire);
+            available = cached_tail - h;
+        }
+
+        size_t n = std::min(max, available);
+        size_t offset = h & mask;
+        size_t first = std::min(n, capacity() - offset);
+        memcpy(dst, &buffer[offset], first);
+        memcpy(dst + first, &buffer[0], n - first);
+
+        head.store(h + n, std::memory_order_release);
+        return n;
+    }
+
+private:
+    std::vector<uint8_t> buffer;
+    size_t mask;
+
+    alignas(64) std::atomic<size_t> head; // Schreibt nur der Leser
+    size_t cached_tail;                   // Letzter gesehener tail (Leser)
+    alignas(64) std::atomic<size_t> tail; // Schreibt nur der Schreiber
+    size_t cached_head;                   // Letzter gesehener head (Schreiber)
+};
+
+// Schlafen und Wecken für eine Seite eines SpscByteRing (Ring leer bzw.
+// voll), der Ring selbst bleibt lock-frei. notify() nimmt den Mutex nur,
+// wenn gerade jemand in wait() schläft, im Normalfall kostet es einen Fence.
+class RingSignal
+{
+public:
+    RingSignal() : sleeping(false) {}
+
+    // Schläft, bis ready() true ist. ready() liest nur atomare Zustände,
+    // z.B. ring.size() oder ein Ende-Flag.
+    template <class Ready>
+    void wait(Ready ready)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        sleeping.store(true, std::memory_order_relaxed);
+        // Gegenstück zum Fence in notify(): entweder sieht ready() die
+        // Änderung, oder notify() sieht sleeping und weckt
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!ready())
+            wake.wait(lock);
+        sleeping.store(false, std::memory_order_relaxed);
+    }
+
+    // Wie wait(), aber höchstens bis deadline
+    template <class Ready>
+    void wait_until(std::chrono::steady_clock::time_point deadline, Ready ready)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!ready() && wake.wait_until(lock, deadline) != std::cv_status::timeout)
+        {
+        }
+        sleeping.store(false, std::memory_order_relaxed);
+    }
+
+    // Nach jeder Änderung, auf die die andere Seite warten könnte
+    void notify()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!sleeping.load(std::memory_order_relaxed))
+            return;
+        std::lock_guard<std::mutex> lock(mutex);
+        wake.notify_all();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::atomic<bool> sleeping;
+};
+
+#endif // SPSC_RING_H
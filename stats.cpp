@@ -1,10 +1,102 @@
 #include "stats.h"
+#include <iomanip>
 #include <iostream>
 
 using namespace std;
 
 Stats global_stats;
 
+static const char *const OVERHEAD_NAMES[OVERHEAD_CATEGORIES][2] = {
+    {"payload", "Nutzdaten"},
+    {"checksum", "Checksum"},
+    {"ack", "ACK/NACK"},
+    {"eot", "EOT"},
+    {"no_data", "NO_DATA"},
+    {"escape", "ESC"},
+    {"channel", "CH"},
+    {"probe", "Probe"},
+    {"retransmit", "Wiederholungen"},
+};
+
+const char *overhead_key(int category)
+{
+    return OVERHEAD_NAMES[category][0];
+}
+
+const char *overhead_label(int category)
+{
+    return OVERHEAD_NAMES[category][1];
+}
+
+void Stats::add_overhead(OverheadCategory category, uint64_t symbols, uint64_t ns)
+{
+    overhead_symbols[category].fetch_add(symbols, memory_order_relaxed);
+    overhead_ns[category].fetch_add(ns, memory_order_relaxed);
+}
+
+StatsSnapshot Stats::snapshot() const
+{
+    StatsSnapshot s;
+    s.bytes_sent = bytes_sent.load();
+    s.bytes_received = bytes_received.load();
+    s.payload_sent = payload_sent.load();
+    s.payload_received = payload_received.load();
+    s.retransmissions = retransmissions.load();
+    s.checksum_errors = checksum_errors.load();
+    s.credit_stalls = credit_stalls.load();
+    s.credit_wait_ns = credit_wait_ns.load();
+    s.poll_iterations = poll_iterations.load();
+    s.io_time_ns = io_time_ns.load();
+    s.sleep_time_ns = sleep_time_ns.load();
+    s.sleep_requested_ns = sleep_requested_ns.load();
+    s.near_timeouts = near_timeouts.load();
+    s.symbol_timeouts = symbol_timeouts.load();
+    s.write_errors = write_errors.load();
+    for (int c = 0; c < OVERHEAD_CATEGORIES; c++)
+    {
+        s.overhead_symbols[c] = overhead_symbols[c].load();
+        s.overhead_ns[c] = overhead_ns[c].load();
+    }
+    return s;
+}
+
+// Aufschlüsselung aus OverheadCategory, nur wenn etwas gezählt wurde
+static void print_overhead(const StatsSnapshot &s)
+{
+    uint64_t total_symbols = 0, total_ns = 0;
+    for (int c = 0; c < OVERHEAD_CATEGORIES; c++)
+    {
+        total_symbols += s.overhead_symbols[c];
+        total_ns += s.overhead_ns[c];
+    }
+    if (total_symbols == 0)
+        return;
+
+    cout << "Leitungsnutzung (Symbole / Zeit):" << endl;
+    ios::fmtflags flags = cout.flags();
+    streamsize precision = cout.precision();
+    cout << fixed << setprecision(1);
+    for (int c = 0; c < OVERHEAD_CATEGORIES; c++)
+    {
+        if (s.overhead_symbols[c] == 0)
+            continue;
+
+        cout << "  " << left << setw(16) << overhead_label(c) << right
+             << setw(10) << s.overhead_symbols[c] << " Sym " << setw(5)
+             << s.overhead_symbols[c] * 100.0 / total_symbols << "%  "
+             << setw(10) << s.overhead_ns[c] / 1e6 << " ms " << setw(5)
+             << (total_ns > 0 ? s.overhead_ns[c] * 100.0 / total_ns : 0.0) << "%" << endl;
+    }
+
+    // Alles außer den Nutzdaten ist Overhead
+    uint64_t overhead_symbols = total_symbols - s.overhead_symbols[OVERHEAD_PAYLOAD];
+    uint64_t overhead_ns = total_ns - s.overhead_ns[OVERHEAD_PAYLOAD];
+    cout << "  Overhead:        " << overhead_symbols * 100.0 / total_symbols << "% der Symbole, "
+         << (total_ns > 0 ? overhead_ns * 100.0 / total_ns : 0.0) << "% der Zeit" << endl;
+    cout.flags(flags);
+    cout.precision(precision);
+}
+
 void Stats::print()
 {
     cout << "Bytes gesendet:     " << bytes_sent << endl;
@@ -15,4 +107,54 @@ void Stats::print()
     {
         cout << "Fehlerrate:         " << (checksum_errors * 100.0 / bytes_sent) << "%" << endl;
     }
+
+    if (symbol_tx.count() + symbol_rx.count() + byte_rtt.count() + message.count() > 0)
+    {
+        cout << "Latenzen:" << endl;
+        symbol_tx.print("Symbol senden");
+        symbol_rx.print("Symbol empfangen");
+        byte_rtt.print("Byte ACK-RTT");
+        message.print("Nachricht");
+    }
+
+    print_overhead(snapshot());
+
+    if (credit_stalls > 0)
+    {
+        cout << "Credit-Pausen:      " << credit_stalls << " (" << credit_wait_ns / 1e6
+             << " ms auf Platz beim Empfaenger gewartet)" << endl;
+    }
+    if (write_errors > 0)
+    {
+        cout << "Schreibfehler:      " << write_errors << " (Ausgabedatei, Batch erneut versucht)" << endl;
+    }
+
+    if (poll_iterations > 0)
+    {
+        cout << "Poll-Effizienz:" << endl;
+        cout << "  Polls gesamt:       " << poll_iterations << endl;
+        cout << "  I/O-Zeit:           " << io_time_ns / 1e6 << " ms" << endl;
+        cout << "  Schlafzeit:         " << sleep_time_ns / 1e6 << " ms (angefordert: "
+             << sleep_requested_ns / 1e6 << " ms)" << endl;
+        cout << "  Knapp vor Timeout:  " << near_timeouts << endl;
+        cout << "  Symbol-Timeouts:    " << symbol_timeouts << endl;
+        polls_per_symbol.print("Polls/Symbol", 1.0, "");
+        read_io.print("read_input");
+
+        // Grobe Einordnung, woran ein langsamer Link hängt
+        cout << "  Engpass (Schaetzung): ";
+        if (sleep_requested_ns > 0 && sleep_time_ns > sleep_requested_ns * 3 / 2)
+        {
+            cout << "Scheduler (Schlafen dauert "
+                 << (double)sleep_time_ns / sleep_requested_ns << "x laenger als angefordert)" << endl;
+        }
+        else if (io_time_ns > sleep_time_ns)
+        {
+            cout << "I/O (Kabel- bzw. Registerzugriffe)" << endl;
+        }
+        else
+        {
+            cout << "Warten auf Gegenstelle" << endl;
+        }
+    }
 }
@@ -1,15 +1,89 @@
 #ifndef STATS_H
 #define STATS_H
 
-// Statistik
+#include "histogram.h"
+#include <atomic>
+#include <cstdint>
+
+// Wofür die Leitung genutzt wurde. Jedes Byte sind 4 Symbole à 2 Bit.
+// Ein Versuch, der mit NACK/Timeout bzw. falscher Checksum endet, zählt
+// komplett (Daten, Checksum, Antwort) als OVERHEAD_RETRANSMIT.
+enum OverheadCategory
+{
+    OVERHEAD_PAYLOAD = 0, // Nutzdaten-Byte
+    OVERHEAD_CHECKSUM,    // Checksum-Byte
+    OVERHEAD_ACK,         // ACK_BYTE/NACK_BYTE-Antwort
+    OVERHEAD_EOT,         // EOT_BYTE bzw. ABORT_BYTE
+    OVERHEAD_NO_DATA,     // NO_DATA_BYTE (Ping-Pong-Modus in ACKFix)
+    OVERHEAD_ESCAPE,      // ESC_BYTE vor maskierten Nutzdaten
+    OVERHEAD_CHANNEL,     // CHANNEL_BYTE (Kanalwechsel)
+    OVERHEAD_PROBE,       // PROBE_BYTE bei vollem Empfangsfenster
+    OVERHEAD_RETRANSMIT,  // Fehlgeschlagene Versuche
+    OVERHEAD_CATEGORIES
+};
+
+const char *overhead_key(int category);   // z.B. "checksum", für Export
+const char *overhead_label(int category); // z.B. "Checksum", für print()
+
+// Momentaufnahme aller Zähler, z.B. für Export und Ratenberechnung
+struct StatsSnapshot
+{
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+    uint64_t payload_sent;
+    uint64_t payload_received;
+    uint64_t retransmissions;
+    uint64_t checksum_errors;
+    uint64_t credit_stalls;
+    uint64_t credit_wait_ns;
+    uint64_t poll_iterations;
+    uint64_t io_time_ns;
+    uint64_t sleep_time_ns;
+    uint64_t sleep_requested_ns;
+    uint64_t near_timeouts;
+    uint64_t symbol_timeouts;
+    uint64_t write_errors;
+    uint64_t overhead_symbols[OVERHEAD_CATEGORIES];
+    uint64_t overhead_ns[OVERHEAD_CATEGORIES];
+};
+
+// Statistik (Zähler atomar, da Full-Duplex und Exporter parallel zugreifen)
 class Stats
 {
 public:
-    int bytes_sent = 0;
-    int bytes_received = 0;
-    int retransmissions = 0;
-    int checksum_errors = 0;
+    std::atomic<uint64_t> bytes_sent{0};
+    std::atomic<uint64_t> bytes_received{0};
+    std::atomic<uint64_t> payload_sent{0};     // Nur Nutzdaten, ohne EOT/ESC/Kanal/Probe
+    std::atomic<uint64_t> payload_received{0}; // dito, empfangen
+    std::atomic<uint64_t> retransmissions{0};
+    std::atomic<uint64_t> checksum_errors{0};
+    std::atomic<uint64_t> credit_stalls{0};  // Pausen, weil die Gegenseite keinen Platz hatte
+    std::atomic<uint64_t> credit_wait_ns{0}; // Davon insgesamt gewartet
+    std::atomic<uint64_t> write_errors{0};   // Fehlgeschlagene Schreibversuche der Ausgabedatei
+    std::atomic<uint64_t> tx_queue_bytes{0}; // Gelesen, aber noch nicht bestätigt (Gauge)
+
+    // Latenzen in Nanosekunden
+    LatencyHistogram symbol_tx; // send_2bits: Symbol anlegen bis ACK-Flanke
+    LatencyHistogram symbol_rx; // receive_2bits: Warten bis CLOCK-Flanke
+    LatencyHistogram byte_rtt;  // Daten + Checksum senden bis ACK/NACK
+    LatencyHistogram message;   // Erstes Byte bis EOT
+
+    // Poll-Effizienz der Handshake-Warteschleifen
+    std::atomic<uint64_t> poll_iterations{0};
+    std::atomic<uint64_t> io_time_ns{0};         // In read_input/write_output
+    std::atomic<uint64_t> sleep_time_ns{0};      // Tatsächlich geschlafen
+    std::atomic<uint64_t> sleep_requested_ns{0}; // Angeforderte Schlafzeit
+    std::atomic<uint64_t> near_timeouts{0};      // Symbol erst nach >80% des Timeouts
+    std::atomic<uint64_t> symbol_timeouts{0};
+    LatencyHistogram polls_per_symbol; // Anzahl Polls, keine Zeit
+    LatencyHistogram read_io;          // Dauer eines read_input()
+
+    // Symbole und Leitungszeit pro OverheadCategory
+    std::atomic<uint64_t> overhead_symbols[OVERHEAD_CATEGORIES]{};
+    std::atomic<uint64_t> overhead_ns[OVERHEAD_CATEGORIES]{};
+    void add_overhead(OverheadCategory category, uint64_t symbols, uint64_t ns);
 
+    StatsSnapshot snapshot() const;
     void print();
 };
 
@@ -0,0 +1,375 @@
+// Monte-Carlo-Sweep: viele simulierte Links parallel in einem Prozess.
+//
+// Jeder Gitterpunkt (Fehlerrate x Leitungsfehler x Protokoll-Einstellung x Lauf)
+// betreibt zwei B15Simulator-Instanzen an einem PatchCableMemory und überträgt
+// eine zufällige Nutzlast mit send_byte_with_checksum/receive_byte_with_checksum.
+// Ergebnis ist eine CSV mit Goodput, Wiederholungen und Latenz-Perzentilen.
+
+#include "b15simulator.h"
+#include "error_injector.h"
+#include "logger.h"
+#include "patch_cable.h"
+#include "protocol.h"
+#include "stats.h"
+#include "wire_faults.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+struct SweepCell
+{
+    double error_rate;
+    string fault_spec; // "none" = keine Leitungsfehler
+    ProtocolSettings settings;
+    int run;
+    uint64_t seed;
+};
+
+struct SweepResult
+{
+    size_t payload_bytes;
+    size_t acked_bytes;
+    double elapsed_s;
+    uint64_t retransmissions;
+    uint64_t checksum_errors;
+    bool link_failed;
+    bool intact; // Empfangene Nachricht entspricht exakt der Nutzlast
+    size_t unprotected_corrupt; // Verfälschte Bytes derselben Nutzlast ohne Checksum und ARQ
+    double lat_p50_us;
+    double lat_p90_us;
+    double lat_p99_us;
+    double lat_max_us;
+
+    // Poll-Effizienz beider Boards
+    uint64_t poll_iterations;
+    double io_ms;
+    double sleep_ms;
+    double sleep_requested_ms;
+    uint64_t near_timeouts;
+    uint64_t symbol_timeouts;
+
+    // Anteil der Leitungsnutzung ohne Nutzdaten (Sicht des Senders)
+    double overhead_symbols_pct;
+    double overhead_time_pct;
+};
+
+static vector<string> split(const string &text, char sep)
+{
+    vector<string> parts;
+    stringstream ss(text);
+    string part;
+    while (getline(ss, part, sep))
+    {
+        if (!part.empty())
+            parts.push_back(part);
+    }
+    return parts;
+}
+
+static double percentile(const vector<double> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+    size_t index = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+static SweepResult run_link(const SweepCell &cell, size_t payload_bytes)
+{
+    SweepResult result = SweepResult();
+    result.payload_bytes = payload_bytes;
+
+    // Nur druckbare Zeichen, damit EOT/0xFF nicht in der Nutzlast vorkommen
+    mt19937_64 rng(cell.seed);
+    string payload(payload_bytes, ' ');
+    for (size_t i = 0; i < payload_bytes; i++)
+    {
+        payload[i] = (char)(0x20 + rng() % 0x5F);
+    }
+
+    // Vergleichswert ohne Checksum und ARQ: dieselbe Fehlerrate in einem
+    // Aufruf auf die ganze Nutzlast, eigener Seed, damit der Link dieselbe
+    // Fehlerfolge sieht wie ohne diesen Vergleich
+    {
+        vector<uint8_t> unprotected(payload.begin(), payload.end());
+        ErrorInjector channel(0);
+        channel.set_seed(cell.seed + 3);
+        channel.set_error_rate(cell.error_rate);
+        result.unprotected_corrupt = channel.inject_errors(unprotected.data(), unprotected.size());
+    }
+
+    PatchCableMemory cable;
+    Stats stats_a, stats_b;
+    ErrorInjector injector_a(0), injector_b(0); // Ausgaben über den Logger, hier aus
+    injector_b.set_seed(cell.seed);
+    injector_b.set_error_rate(cell.error_rate);
+
+    if (cell.fault_spec != "none")
+    {
+        WireFault fault;
+        parse_wire_fault(cell.fault_spec, fault);
+        cable.wire_faults_a().add(fault);
+        cable.wire_faults_b().add(fault);
+        cable.wire_faults_a().set_seed(cell.seed + 1);
+        cable.wire_faults_b().set_seed(cell.seed + 2);
+    }
+
+    B15Simulator board_a(true, cable);
+    B15Simulator board_b(false, cable);
+
+    board_a.set_protocol_settings(cell.settings);
+    board_b.set_protocol_settings(cell.settings);
+    board_a.set_stats(&stats_a);
+    board_b.set_stats(&stats_b);
+    board_a.set_error_injector(&injector_a);
+    board_b.set_error_injector(&injector_b);
+
+    atomic<bool> sender_done(false);
+    string received;
+
+    thread receiver([&]()
+                    {
+        bool eot_seen = false;
+        while (!sender_done)
+        {
+            uint8_t byte = board_b.receive_byte_with_checksum();
+            if (byte == 0xFF)
+                continue;
+            if (byte == EOT_BYTE)
+                eot_seen = true;
+            else if (!eot_seen)
+                received += (char)byte;
+        } });
+
+    vector<double> latencies_us;
+    latencies_us.reserve(payload_bytes);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t i = 0; i < payload_bytes; i++)
+    {
+        chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+        if (!board_a.send_byte_with_checksum(payload[i]))
+        {
+            result.link_failed = true;
+            break;
+        }
+        latencies_us.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count());
+        result.acked_bytes++;
+    }
+    if (!result.link_failed && !board_a.send_byte_with_checksum(EOT_BYTE))
+    {
+        result.link_failed = true;
+    }
+    result.elapsed_s = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    sender_done = true;
+    receiver.join();
+
+    sort(latencies_us.begin(), latencies_us.end());
+    result.retransmissions = stats_a.retransmissions;
+    result.checksum_errors = stats_b.checksum_errors;
+    result.intact = (received == payload);
+    result.lat_p50_us = percentile(latencies_us, 0.50);
+    result.lat_p90_us = percentile(latencies_us, 0.90);
+    result.lat_p99_us = percentile(latencies_us, 0.99);
+    result.lat_max_us = latencies_us.empty() ? 0.0 : latencies_us.back();
+    result.poll_iterations = stats_a.poll_iterations + stats_b.poll_iterations;
+    result.io_ms = (stats_a.io_time_ns + stats_b.io_time_ns) / 1e6;
+    result.sleep_ms = (stats_a.sleep_time_ns + stats_b.sleep_time_ns) / 1e6;
+    result.sleep_requested_ms = (stats_a.sleep_requested_ns + stats_b.sleep_requested_ns) / 1e6;
+    result.near_timeouts = stats_a.near_timeouts + stats_b.near_timeouts;
+    result.symbol_timeouts = stats_a.symbol_timeouts + stats_b.symbol_timeouts;
+
+    StatsSnapshot wire = stats_a.snapshot();
+    uint64_t total_symbols = 0, total_ns = 0;
+    for (int c = 0; c < OVERHEAD_CATEGORIES; c++)
+    {
+        total_symbols += wire.overhead_symbols[c];
+        total_ns += wire.overhead_ns[c];
+    }
+    result.overhead_symbols_pct = total_symbols > 0
+        ? (total_symbols - wire.overhead_symbols[OVERHEAD_PAYLOAD]) * 100.0 / total_symbols
+        : 0.0;
+    result.overhead_time_pct = total_ns > 0
+        ? (total_ns - wire.overhead_ns[OVERHEAD_PAYLOAD]) * 100.0 / total_ns
+        : 0.0;
+    return result;
+}
+
+static void print_usage(const char *prog)
+{
+    cout << "Usage: " << prog << " [optionen]" << endl;
+    cout << "  --rates=0,1,5,10,20       Byte-Fehlerraten in Prozent" << endl;
+    cout << "  --faults=none,...         Leitungsfehler (Format wie --fault, 'none' = ohne)" << endl;
+    cout << "  --poll-us=100             Poll-Intervalle in Mikrosekunden" << endl;
+    cout << "  --retries=5               Max. Versuche pro Byte" << endl;
+    cout << "  --timeout-ms=500          Timeout pro 2-Bit-Symbol" << endl;
+    cout << "  --bytes=256               Nutzlast pro Link" << endl;
+    cout << "  --runs=1                  Wiederholungen pro Gitterpunkt" << endl;
+    cout << "  --jobs=<kerne>            Parallele Links" << endl;
+    cout << "  --seed=1                  Basis-Seed fuer reproduzierbare Laeufe" << endl;
+    cout << "  --out=sweep.csv           Ausgabedatei" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    vector<string> rates = split("0,1,5,10,20", ',');
+    vector<string> faults = split("none", ',');
+    vector<string> poll_us = split("100", ',');
+    vector<string> retries = split("5", ',');
+    int timeout_ms = 500;
+    size_t payload_bytes = 256;
+    int runs = 1;
+    unsigned jobs = thread::hardware_concurrency();
+    uint64_t seed = 1;
+    string out = "sweep.csv";
+
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        size_t eq = arg.find('=');
+        string key = arg.substr(0, eq);
+        string value = (eq == string::npos) ? "" : arg.substr(eq + 1);
+
+        if (key == "--rates")
+            rates = split(value, ',');
+        else if (key == "--faults")
+            faults = split(value, ',');
+        else if (key == "--poll-us")
+            poll_us = split(value, ',');
+        else if (key == "--retries")
+            retries = split(value, ',');
+        else if (key == "--timeout-ms")
+            timeout_ms = atoi(value.c_str());
+        else if (key == "--bytes")
+            payload_bytes = strtoul(value.c_str(), nullptr, 10);
+        else if (key == "--runs")
+            runs = atoi(value.c_str());
+        else if (key == "--jobs")
+            jobs = atoi(value.c_str());
+        else if (key == "--seed")
+            seed = strtoull(value.c_str(), nullptr, 10);
+        else if (key == "--out")
+            out = value;
+        else
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    for (size_t i = 0; i < faults.size(); i++)
+    {
+        WireFault fault;
+        if (faults[i] != "none" && !parse_wire_fault(faults[i], fault))
+        {
+            cerr << "Ungueltige Fault-Spezifikation: " << faults[i] << endl;
+            return 1;
+        }
+    }
+    if (jobs == 0)
+        jobs = 1;
+
+    // Viele Links parallel: Ausgaben pro Nachricht wären nur Rauschen
+    AsyncLogger::instance().set_level(LOG_LEVEL_OFF);
+
+    // Gitter aufbauen
+    vector<SweepCell> cells;
+    for (size_t r = 0; r < rates.size(); r++)
+        for (size_t f = 0; f < faults.size(); f++)
+            for (size_t p = 0; p < poll_us.size(); p++)
+                for (size_t m = 0; m < retries.size(); m++)
+                    for (int run = 0; run < runs; run++)
+                    {
+                        SweepCell cell;
+                        cell.error_rate = atof(rates[r].c_str());
+                        cell.fault_spec = faults[f];
+                        cell.settings.poll_interval_us = max(1, atoi(poll_us[p].c_str()));
+                        cell.settings.max_retries = max(1, atoi(retries[m].c_str()));
+                        cell.settings.timeout_polls = max(1, timeout_ms * 1000 / cell.settings.poll_interval_us);
+                        cell.run = run;
+                        cell.seed = seed + cells.size() * 7919;
+                        cells.push_back(cell);
+                    }
+
+    cout << "Sweep: " << cells.size() << " Links, " << jobs << " parallel, "
+         << payload_bytes << " Bytes pro Link" << endl;
+
+    vector<SweepResult> results(cells.size());
+    atomic<size_t> next_cell(0);
+    atomic<size_t> finished(0);
+    mutex print_mutex;
+
+    vector<thread> workers;
+    for (unsigned j = 0; j < jobs; j++)
+    {
+        workers.push_back(thread([&]()
+                                 {
+            size_t index;
+            while ((index = next_cell++) < cells.size())
+            {
+                results[index] = run_link(cells[index], payload_bytes);
+
+                lock_guard<mutex> lock(print_mutex);
+                const SweepCell &cell = cells[index];
+                const SweepResult &res = results[index];
+                ostringstream goodput;
+                goodput << fixed << setprecision(1) << (res.acked_bytes / res.elapsed_s);
+                cout << "[" << ++finished << "/" << cells.size() << "] rate=" << cell.error_rate
+                     << "% fault=" << cell.fault_spec
+                     << " poll=" << cell.settings.poll_interval_us << "us"
+                     << " retries=" << cell.settings.max_retries
+                     << " -> " << goodput.str() << " B/s"
+                     << (res.link_failed ? " FEHLGESCHLAGEN" : "") << endl;
+            } }));
+    }
+    for (size_t j = 0; j < workers.size(); j++)
+    {
+        workers[j].join();
+    }
+
+    ofstream csv(out);
+    if (!csv.is_open())
+    {
+        cerr << "Kann " << out << " nicht schreiben!" << endl;
+        return 1;
+    }
+
+    csv << "error_rate,fault,poll_us,max_retries,run,payload_bytes,acked_bytes,elapsed_s,"
+           "goodput_Bps,retransmissions,checksum_errors,link_failed,intact,unprotected_corrupt_bytes,"
+           "lat_p50_us,lat_p90_us,lat_p99_us,lat_max_us,"
+           "poll_iterations,io_ms,sleep_ms,sleep_requested_ms,near_timeouts,symbol_timeouts,"
+           "overhead_symbols_pct,overhead_time_pct\n";
+    for (size_t i = 0; i < cells.size(); i++)
+    {
+        const SweepCell &cell = cells[i];
+        const SweepResult &res = results[i];
+        csv << cell.error_rate << "," << cell.fault_spec << ","
+            << cell.settings.poll_interval_us << "," << cell.settings.max_retries << ","
+            << cell.run << "," << res.payload_bytes << "," << res.acked_bytes << ","
+            << res.elapsed_s << "," << (res.acked_bytes / res.elapsed_s) << ","
+            << res.retransmissions << "," << res.checksum_errors << ","
+            << res.link_failed << "," << res.intact << "," << res.unprotected_corrupt << ","
+            << res.lat_p50_us << "," << res.lat_p90_us << ","
+            << res.lat_p99_us << "," << res.lat_max_us << ","
+            << res.poll_iterations << "," << res.io_ms << "," << res.sleep_ms << ","
+            << res.sleep_requested_ms << "," << res.near_timeouts << ","
+            << res.symbol_timeouts << "," << res.overhead_symbols_pct << ","
+            << res.overhead_time_pct << "\n";
+    }
+
+    cout << "Ergebnisse geschrieben: " << out << endl;
+    return 0;
+}
@@ -0,0 +1,232 @@
+#include "trace.h"
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <io.h>
+#define TRACE_OPEN_FLAGS (O_WRONLY | O_CREAT | O_TRUNC | O_BINARY)
+#else
+#include <unistd.h>
+#define TRACE_OPEN_FLAGS (O_WRONLY | O_CREAT | O_TRUNC)
+#endif
+
+using namespace std;
+
+static const int MAX_RINGS = 64;
+
+thread_local TraceRing *trace_local_ring = nullptr;
+
+static atomic<TraceRing *> rings[MAX_RINGS];
+static atomic<int> ring_count(0);
+
+// Kein std::string: wird auch aus dem Signal-Handler gelesen
+static char dump_path[256] = "";
+
+static const uint64_t tsc_start = trace_ticks();
+static const uint64_t ns_start = latency_now_ns();
+
+static atomic<bool> exhausted_reported(false);
+
+// Gibt den Ring frei, wenn der Thread endet. Er bleibt mit seinen letzten
+// Einträgen im Dump, bis ein neuer Thread ihn übernimmt.
+struct TraceRingRelease
+{
+    ~TraceRingRelease()
+    {
+        if (trace_local_ring)
+        {
+            trace_local_ring->in_use.store(false, memory_order_release);
+            trace_local_ring = nullptr;
+        }
+    }
+};
+
+static thread_local TraceRingRelease ring_release;
+
+TraceRing *trace_register_ring()
+{
+    (void)&ring_release; // Legt das Objekt für diesen Thread an
+    TraceRing *ring = nullptr;
+
+    // Zuerst den Ring eines beendeten Threads wiederverwenden, damit
+    // langlaufende Prozesse mit wechselnden Threads weiter aufzeichnen
+    int count = ring_count.load(memory_order_acquire);
+    for (int i = 0; i < count && i < MAX_RINGS && !ring; i++)
+    {
+        TraceRing *candidate = rings[i].load(memory_order_acquire);
+        bool expected = false;
+        if (candidate && candidate->in_use.compare_exchange_strong(expected, true))
+        {
+            ring = candidate;
+            ring->head.store(0, memory_order_relaxed);
+            snprintf(ring->name, sizeof(ring->name), "Thread %u", (unsigned)i);
+        }
+    }
+
+    if (!ring && count < MAX_RINGS)
+    {
+        int index = ring_count.fetch_add(1);
+        if (index < MAX_RINGS)
+        {
+            // Ringe bleiben bis Programmende bestehen
+            ring = new TraceRing();
+            ring->head.store(0, memory_order_relaxed);
+            ring->in_use.store(true, memory_order_relaxed);
+            snprintf(ring->name, sizeof(ring->name), "Thread %u", (unsigned)index);
+            rings[index].store(ring, memory_order_release);
+        }
+    }
+
+    if (!ring)
+    {
+        if (!exhausted_reported.exchange(true))
+        {
+            fprintf(stderr, "[TRACE] Alle %d Ringe belegt, weitere Threads werden nicht aufgezeichnet\n",
+                    MAX_RINGS);
+        }
+        return nullptr;
+    }
+
+    trace_local_ring = ring;
+    return ring;
+}
+
+void trace_thread_name(const string &name)
+{
+    TraceRing *ring = trace_local_ring ? trace_local_ring : trace_register_ring();
+    if (ring)
+    {
+        strncpy(ring->name, name.c_str(), sizeof(ring->name) - 1);
+        ring->name[sizeof(ring->name) - 1] = '\0';
+    }
+}
+
+#ifdef SIGUSR1
+static void trace_signal_handler(int)
+{
+    trace_dump();
+}
+#endif
+
+void trace_init(const string &path)
+{
+    strncpy(dump_path, path.c_str(), sizeof(dump_path) - 1);
+    dump_path[sizeof(dump_path) - 1] = '\0';
+
+#ifdef SIGUSR1
+    signal(SIGUSR1, trace_signal_handler);
+#endif
+}
+
+static bool write_all(int fd, const void *data, size_t len)
+{
+    const char *p = (const char *)data;
+    while (len > 0)
+    {
+        int written = (int)write(fd, p, (unsigned)len);
+        if (written <= 0)
+            return false;
+        p += written;
+        len -= written;
+    }
+    return true;
+}
+
+// Nur open/write/close, damit der Dump auch aus dem Signal-Handler geht
+bool trace_dump()
+{
+    if (dump_path[0] == '\0')
+        return false;
+
+    int fd = open(dump_path, TRACE_OPEN_FLAGS, 0644);
+    if (fd < 0)
+        return false;
+
+    int count = ring_count.load(memory_order_acquire);
+    if (count > MAX_RINGS)
+        count = MAX_RINGS;
+
+    TraceFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "B15TRACE", 8);
+    header.version = 1;
+    header.ring_count = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (rings[i].load(memory_order_acquire))
+            header.ring_count++;
+    }
+    header.tsc_start = tsc_start;
+    header.ns_start = ns_start;
+    header.tsc_end = trace_ticks();
+    header.ns_end = latency_now_ns();
+
+    bool ok = write_all(fd, &header, sizeof(header));
+
+    for (int i = 0; i < count && ok; i++)
+    {
+        TraceRing *ring = rings[i].load(memory_order_acquire);
+        if (!ring)
+            continue;
+
+        uint64_t head = ring->head.load(memory_order_acquire);
+        uint32_t n = head < TraceRing::SIZE ? (uint32_t)head : TraceRing::SIZE;
+
+        TraceFileRing info;
+        memset(&info, 0, sizeof(info));
+        memcpy(info.name, ring->name, sizeof(info.name));
+        info.head = head;
+        info.count = n;
+        ok = write_all(fd, &info, sizeof(info));
+
+        // Älteste Einträge zuerst
+        uint32_t start = (uint32_t)((head - n) & (TraceRing::SIZE - 1));
+        uint32_t first = n < TraceRing::SIZE - start ? n : TraceRing::SIZE - start;
+        ok = ok && write_all(fd, &ring->events[start], first * sizeof(TraceEvent));
+        ok = ok && write_all(fd, &ring->events[0], (n - first) * sizeof(TraceEvent));
+    }
+
+    close(fd);
+    return ok;
+}
+
+const char *trace_event_name(uint8_t type)
+{
+    switch (type)
+    {
+    case TRACE_SYMBOL_SENT:
+        return "SYMBOL_SENT";
+    case TRACE_SYMBOL_RECEIVED:
+        return "SYMBOL_RECEIVED";
+    case TRACE_ACK_TOGGLE:
+        return "ACK_TOGGLE";
+    case TRACE_TIMEOUT:
+        return "TIMEOUT";
+    case TRACE_NACK:
+        return "NACK";
+    case TRACE_RETRY:
+        return "RETRY";
+    case TRACE_CHECKSUM_ERROR:
+        return "CHECKSUM_ERROR";
+    case TRACE_LINK_FAILED:
+        return "LINK_FAILED";
+    case TRACE_BYTE_TX_BEGIN:
+        return "BYTE_TX_BEGIN";
+    case TRACE_BYTE_TX_END:
+        return "BYTE_TX_END";
+    case TRACE_BYTE_RX_BEGIN:
+        return "BYTE_RX_BEGIN";
+    case TRACE_BYTE_RX_END:
+        return "BYTE_RX_END";
+    case TRACE_LOCK_WAIT:
+        return "LOCK_WAIT";
+    case TRACE_LOCK_ACQUIRED:
+        return "LOCK_ACQUIRED";
+    case TRACE_LOCK_RELEASED:
+        return "LOCK_RELEASED";
+    default:
+        return "UNKNOWN";
+    }
+}
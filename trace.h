@@ -0,0 +1,154 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "histogram.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Binärer Ereignis-Trace für die Post-mortem-Analyse eines hängenden Links.
+// Jeder Thread schreibt lock-frei in einen eigenen Ring fester Größe (ältere
+// Einträge werden überschrieben). Ein Eintrag kostet nur einen TSC-Lesezugriff
+// und 16 Byte Speicher, verändert das Timing also kaum - anders als verbose.
+// Gedumpt wird bei SIGUSR1 oder über trace_dump(), z.B. bei Link-Abbruch.
+// Dekodieren mit tracetool.exe.
+
+enum TraceEventType
+{
+    TRACE_SYMBOL_SENT = 1, // arg = Ausgangs-Nibble
+    TRACE_SYMBOL_RECEIVED, // arg = 2 Datenbits, value = Polls
+    TRACE_ACK_TOGGLE,      // arg = neuer ACK-Pegel, value = Polls
+    TRACE_TIMEOUT,         // arg = 0 beim Senden, 1 beim Empfangen
+    TRACE_NACK,            // arg = Versuch
+    TRACE_RETRY,           // arg = Versuch
+    TRACE_CHECKSUM_ERROR,  // arg = Byte, value = empfangene Checksum
+    TRACE_LINK_FAILED,     // arg = Byte
+    TRACE_BYTE_TX_BEGIN,   // send_byte_with_checksum, arg = Byte
+    TRACE_BYTE_TX_END,     // arg = Byte, value = 1 bei ACK
+    TRACE_BYTE_RX_BEGIN,   // receive_byte_with_checksum
+    TRACE_BYTE_RX_END,     // arg = Byte, value = 1 bei gültiger Checksum
+    TRACE_LOCK_WAIT,       // Warten auf Mutex beginnt, arg = TraceLock
+    TRACE_LOCK_ACQUIRED,   // arg = TraceLock
+    TRACE_LOCK_RELEASED,   // arg = TraceLock
+    TRACE_EVENT_TYPES
+};
+
+enum TraceLock
+{
+    TRACE_LOCK_CABLE = 0 // cable_mutex im Full-Duplex-Modus
+};
+
+struct TraceEvent
+{
+    uint64_t tsc;
+    uint8_t type;
+    uint8_t arg;
+    uint16_t reserved;
+    uint32_t value;
+};
+
+struct TraceRing
+{
+    static const uint32_t SIZE = 8192; // Zweierpotenz
+    static const int NAME_LEN = 16;
+
+    std::atomic<uint64_t> head; // Anzahl je geschriebener Einträge
+    std::atomic<bool> in_use;   // false, sobald der Thread beendet ist
+    char name[NAME_LEN];
+    TraceEvent events[SIZE];
+};
+
+// Dump-Format: Header, dann pro Ring TraceFileRing + count Einträge
+// in zeitlicher Reihenfolge. Die beiden Zeitpaare erlauben die Umrechnung
+// von TSC-Ticks in Nanosekunden.
+struct TraceFileHeader
+{
+    char magic[8]; // "B15TRACE"
+    uint32_t version;
+    uint32_t ring_count;
+    uint64_t tsc_start;
+    uint64_t ns_start;
+    uint64_t tsc_end;
+    uint64_t ns_end;
+};
+
+struct TraceFileRing
+{
+    char name[TraceRing::NAME_LEN];
+    uint64_t head;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+// Zeitstempel: TSC auf x86, sonst steady_clock in ns
+inline uint64_t trace_ticks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return latency_now_ns();
+#endif
+}
+
+extern thread_local TraceRing *trace_local_ring;
+// Ring für den aufrufenden Thread, bevorzugt der eines beendeten Threads.
+// nullptr (mit einmaliger Warnung), wenn alle Ringe in Benutzung sind.
+TraceRing *trace_register_ring();
+
+inline void trace(TraceEventType type, uint8_t arg = 0, uint32_t value = 0)
+{
+    TraceRing *ring = trace_local_ring;
+    if (!ring && !(ring = trace_register_ring()))
+        return;
+
+    // Nur der eigene Thread schreibt, der Dump liest head mit acquire
+    uint64_t pos = ring->head.load(std::memory_order_relaxed);
+    TraceEvent &e = ring->events[pos & (TraceRing::SIZE - 1)];
+    e.tsc = trace_ticks();
+    e.type = (uint8_t)type;
+    e.arg = arg;
+    e.reserved = 0;
+    e.value = value;
+    ring->head.store(pos + 1, std::memory_order_release);
+}
+
+// Begin-/End-Paar um einen Abschnitt mit mehreren Rücksprüngen
+class TraceScope
+{
+public:
+    TraceScope(TraceEventType begin, TraceEventType end, uint8_t arg = 0)
+        : end_type(end), end_arg(arg), end_value(0)
+    {
+        trace(begin, arg);
+    }
+    ~TraceScope() { trace(end_type, end_arg, end_value); }
+
+    void set_result(uint8_t arg, uint32_t value)
+    {
+        end_arg = arg;
+        end_value = value;
+    }
+
+private:
+    TraceEventType end_type;
+    uint8_t end_arg;
+    uint32_t end_value;
+};
+
+// Dump-Datei festlegen und SIGUSR1-Handler installieren (falls vorhanden).
+// Ohne trace_init() wird zwar aufgezeichnet, aber nie gedumpt.
+void trace_init(const std::string &dump_path);
+
+// Name des aufrufenden Threads im Dump, z.B. "A TX"
+void trace_thread_name(const std::string &name);
+
+// Schreibt alle Ringe in die Dump-Datei. Async-signal-safe.
+bool trace_dump();
+
+const char *trace_event_name(uint8_t type);
+
+#endif // TRACE_H
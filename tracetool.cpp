@@ -0,0 +1,403 @@
+// Dekodiert Trace-Dumps (siehe trace.h). Ohne Optionen werden alle Ereignisse
+// aller Threads zeitlich sortiert als Text ausgegeben. Mit --chrome entsteht
+// eine Chrome-Trace-Event-JSON-Datei für chrome://tracing bzw. ui.perfetto.dev:
+// ein Prozess pro Dump, pro Thread je eine Spur für TX, RX und Mutex.
+//
+// Aufruf: tracetool.exe [--chrome=<out.json>] [--bin-ms=<n>] <dump.bin>...
+// Dumps beider Boards (trace_A.bin trace_B.bin) lassen sich gemeinsam laden,
+// solange beide Prozesse auf demselben Rechner liefen (gemeinsamer TSC).
+
+#include "trace.h"
+#include <algorithm>
+#include <bitset>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+struct DecodedEvent
+{
+    double time_us; // Relativ zum ersten Ereignis aller Dumps
+    int dump;
+    int ring;
+    TraceEvent event;
+};
+
+struct DumpFile
+{
+    string path;
+    double ticks_per_ns;
+    vector<string> ring_names;
+};
+
+// Spuren pro Thread in der Chrome-Ansicht
+enum Track
+{
+    TRACK_TX = 0,
+    TRACK_RX = 1,
+    TRACK_MUTEX = 2,
+    TRACKS_PER_RING = 3
+};
+
+static string describe(const TraceEvent &e)
+{
+    ostringstream out;
+    switch (e.type)
+    {
+    case TRACE_SYMBOL_SENT:
+        out << "nibble=" << bitset<4>(e.arg);
+        break;
+    case TRACE_SYMBOL_RECEIVED:
+        out << "bits=" << bitset<2>(e.arg) << " polls=" << e.value;
+        break;
+    case TRACE_ACK_TOGGLE:
+        out << "ack=" << (e.arg ? 1 : 0) << " polls=" << e.value;
+        break;
+    case TRACE_TIMEOUT:
+        out << (e.arg ? "beim Empfangen" : "beim Senden");
+        break;
+    case TRACE_NACK:
+    case TRACE_RETRY:
+        out << "versuch=" << (int)e.arg;
+        break;
+    case TRACE_CHECKSUM_ERROR:
+        out << "byte=0x" << hex << (int)e.arg << " checksum=0x" << e.value << dec;
+        break;
+    case TRACE_LINK_FAILED:
+    case TRACE_BYTE_TX_BEGIN:
+        out << "byte=0x" << hex << (int)e.arg << dec;
+        break;
+    case TRACE_BYTE_TX_END:
+    case TRACE_BYTE_RX_END:
+        out << "byte=0x" << hex << (int)e.arg << dec << (e.value ? " ok" : " fehlgeschlagen");
+        break;
+    case TRACE_LOCK_WAIT:
+    case TRACE_LOCK_ACQUIRED:
+    case TRACE_LOCK_RELEASED:
+        out << "cable_mutex";
+        break;
+    }
+    return out.str();
+}
+
+// Spur eines Ereignisses innerhalb seines Threads
+static int track_of(const TraceEvent &e)
+{
+    switch (e.type)
+    {
+    case TRACE_BYTE_TX_BEGIN:
+    case TRACE_BYTE_TX_END:
+    case TRACE_SYMBOL_SENT:
+    case TRACE_ACK_TOGGLE:
+    case TRACE_NACK:
+    case TRACE_RETRY:
+    case TRACE_LINK_FAILED:
+        return TRACK_TX;
+    case TRACE_TIMEOUT:
+        return e.arg ? TRACK_RX : TRACK_TX;
+    case TRACE_LOCK_WAIT:
+    case TRACE_LOCK_ACQUIRED:
+    case TRACE_LOCK_RELEASED:
+        return TRACK_MUTEX;
+    default:
+        return TRACK_RX;
+    }
+}
+
+static bool read_dump(const string &path, int index, DumpFile &dump,
+                      vector<DecodedEvent> &events, vector<uint64_t> &ticks)
+{
+    ifstream in(path.c_str(), ios::binary);
+    if (!in)
+    {
+        cerr << "Datei nicht lesbar: " << path << endl;
+        return false;
+    }
+
+    TraceFileHeader header;
+    if (!in.read((char *)&header, sizeof(header)) || memcmp(header.magic, "B15TRACE", 8) != 0)
+    {
+        cerr << "Kein Trace-Dump: " << path << endl;
+        return false;
+    }
+
+    // TSC-Ticks pro Nanosekunde aus den beiden Zeitpaaren
+    dump.path = path;
+    dump.ticks_per_ns = 1.0;
+    if (header.ns_end > header.ns_start && header.tsc_end > header.tsc_start)
+    {
+        dump.ticks_per_ns = (double)(header.tsc_end - header.tsc_start) / (header.ns_end - header.ns_start);
+    }
+
+    for (uint32_t r = 0; r < header.ring_count; r++)
+    {
+        TraceFileRing info;
+        if (!in.read((char *)&info, sizeof(info)))
+        {
+            cerr << path << ": Dump unvollstaendig (Ring " << r << ")" << endl;
+            return false;
+        }
+        dump.ring_names.push_back(string(info.name, strnlen(info.name, sizeof(info.name))));
+
+        if (info.head > info.count)
+        {
+            cerr << "[" << dump.ring_names.back() << "] " << (info.head - info.count)
+                 << " aeltere Ereignisse ueberschrieben" << endl;
+        }
+
+        for (uint32_t i = 0; i < info.count; i++)
+        {
+            DecodedEvent d;
+            if (!in.read((char *)&d.event, sizeof(d.event)))
+            {
+                cerr << path << ": Dump unvollstaendig (Ring " << r << ")" << endl;
+                return false;
+            }
+            d.dump = index;
+            d.ring = r;
+            events.push_back(d);
+            ticks.push_back(d.event.tsc);
+        }
+    }
+    return true;
+}
+
+static void print_text(const vector<DumpFile> &dumps, const vector<DecodedEvent> &events)
+{
+    cout << events.size() << " Ereignisse aus " << dumps.size() << " Dump(s)" << endl;
+
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        const DecodedEvent &d = events[i];
+        cout << fixed << setprecision(6) << setw(14) << d.time_us / 1000.0 << " ms  "
+             << left << setw(16) << dumps[d.dump].ring_names[d.ring]
+             << setw(16) << trace_event_name(d.event.type)
+             << right << describe(d.event) << endl;
+    }
+}
+
+// Text als JSON-String samt Anführungszeichen. Pfade (Backslashes unter
+// Windows) und Thread-Namen kommen aus Dateien bzw. vom Benutzer.
+static string json_string(const string &text)
+{
+    ostringstream out;
+    out << '"';
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        unsigned char c = text[i];
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if (c == '\n')
+            out << "\\n";
+        else if (c == '\t')
+            out << "\\t";
+        else if (c < 0x20)
+            out << "\\u" << hex << setw(4) << setfill('0') << (int)c << dec << setfill(' ');
+        else
+            out << c;
+    }
+    out << '"';
+    return out.str();
+}
+
+static void chrome_event(ostream &out, bool &first, const char *ph, const string &name,
+                         double ts, int pid, int tid, const string &args = "")
+{
+    out << (first ? "\n" : ",\n") << "{\"name\":" << json_string(name) << ",\"ph\":\"" << ph
+        << "\",\"ts\":" << fixed << setprecision(3) << ts << ",\"pid\":" << pid << ",\"tid\":" << tid;
+    if (ph[0] == 'i')
+        out << ",\"s\":\"t\"";
+    if (!args.empty())
+        out << ",\"args\":{" << args << "}";
+    out << "}";
+    first = false;
+}
+
+static string hex_arg(const char *key, int value)
+{
+    ostringstream out;
+    out << "\"" << key << "\":\"0x" << hex << setw(2) << setfill('0') << value << "\"";
+    return out.str();
+}
+
+static bool write_chrome(const string &path, const vector<DumpFile> &dumps,
+                         const vector<DecodedEvent> &events, double bin_ms)
+{
+    ofstream out(path.c_str());
+    if (!out)
+    {
+        cerr << "Datei nicht schreibbar: " << path << endl;
+        return false;
+    }
+
+    bool first = true;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    // Durchsatz pro Dump in Zeitfenstern von bin_ms
+    vector<vector<uint64_t>> tx_bins(dumps.size()), rx_bins(dumps.size());
+    set<pair<int, int>> used_tracks;
+    double bin_us = bin_ms * 1000.0;
+
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        const DecodedEvent &d = events[i];
+        const TraceEvent &e = d.event;
+        int pid = d.dump + 1;
+        int base = d.ring * TRACKS_PER_RING;
+        double ts = d.time_us;
+        int tid = base + track_of(e);
+        used_tracks.insert(make_pair(pid, tid));
+
+        switch (e.type)
+        {
+        case TRACE_BYTE_TX_BEGIN:
+            chrome_event(out, first, "B", "send_byte_with_checksum", ts, pid, tid,
+                         hex_arg("byte", e.arg));
+            break;
+        case TRACE_BYTE_TX_END:
+            chrome_event(out, first, "E", "send_byte_with_checksum", ts, pid, tid,
+                         string("\"ack\":") + (e.value ? "true" : "false"));
+            break;
+        case TRACE_BYTE_RX_BEGIN:
+            chrome_event(out, first, "B", "receive_byte_with_checksum", ts, pid, tid);
+            break;
+        case TRACE_BYTE_RX_END:
+            chrome_event(out, first, "E", "receive_byte_with_checksum", ts, pid, tid,
+                         hex_arg("byte", e.arg) + ",\"ok\":" + (e.value ? "true" : "false"));
+            break;
+        case TRACE_LOCK_WAIT:
+            chrome_event(out, first, "B", "cable_mutex warten", ts, pid, tid);
+            break;
+        case TRACE_LOCK_ACQUIRED:
+            chrome_event(out, first, "E", "cable_mutex warten", ts, pid, tid);
+            chrome_event(out, first, "B", "cable_mutex gehalten", ts, pid, tid);
+            break;
+        case TRACE_LOCK_RELEASED:
+            chrome_event(out, first, "E", "cable_mutex gehalten", ts, pid, tid);
+            break;
+        case TRACE_SYMBOL_SENT:
+        case TRACE_ACK_TOGGLE:
+        case TRACE_NACK:
+        case TRACE_RETRY:
+        case TRACE_LINK_FAILED:
+            chrome_event(out, first, "i", trace_event_name(e.type), ts, pid, tid,
+                         "\"info\":" + json_string(describe(e)));
+            break;
+        case TRACE_TIMEOUT:
+            chrome_event(out, first, "i", trace_event_name(e.type), ts, pid, tid);
+            break;
+        default:
+            chrome_event(out, first, "i", trace_event_name(e.type), ts, pid, tid,
+                         "\"info\":" + json_string(describe(e)));
+            break;
+        }
+
+        if ((e.type == TRACE_BYTE_TX_END || e.type == TRACE_BYTE_RX_END) && e.value)
+        {
+            vector<uint64_t> &bins = (e.type == TRACE_BYTE_TX_END ? tx_bins : rx_bins)[d.dump];
+            size_t bin = (size_t)(ts / bin_us);
+            if (bins.size() <= bin)
+                bins.resize(bin + 1, 0);
+            bins[bin]++;
+        }
+    }
+
+    for (size_t d = 0; d < dumps.size(); d++)
+    {
+        size_t n = max(tx_bins[d].size(), rx_bins[d].size());
+        for (size_t b = 0; b <= n; b++)
+        {
+            uint64_t tx = b < tx_bins[d].size() ? tx_bins[d][b] : 0;
+            uint64_t rx = b < rx_bins[d].size() ? rx_bins[d][b] : 0;
+            ostringstream args;
+            args << "\"tx_Bps\":" << tx / (bin_ms / 1000.0) << ",\"rx_Bps\":" << rx / (bin_ms / 1000.0);
+            chrome_event(out, first, "C", "Durchsatz", b * bin_us, (int)d + 1, 0, args.str());
+        }
+    }
+
+    // Namen für Prozesse (Dumps) und Spuren. Heißt der Thread schon nach
+    // der Richtung (Full-Duplex: "Board A TX"), wird sie nicht wiederholt.
+    static const char *track_names[TRACKS_PER_RING] = {"TX", "RX", "Mutex"};
+    for (size_t d = 0; d < dumps.size(); d++)
+    {
+        chrome_event(out, first, "M", "process_name", 0, (int)d + 1, 0,
+                     "\"name\":" + json_string(dumps[d].path));
+    }
+    for (set<pair<int, int>>::const_iterator it = used_tracks.begin(); it != used_tracks.end(); ++it)
+    {
+        const string &thread = dumps[it->first - 1].ring_names[it->second / TRACKS_PER_RING];
+        string track = track_names[it->second % TRACKS_PER_RING];
+        string name = thread;
+        if (thread.size() < track.size() || thread.compare(thread.size() - track.size(), track.size(), track) != 0)
+            name += " (" + track + ")";
+
+        chrome_event(out, first, "M", "thread_name", 0, it->first, it->second, "\"name\":" + json_string(name));
+        chrome_event(out, first, "M", "thread_sort_index", 0, it->first, it->second,
+                     "\"sort_index\":" + to_string(it->second));
+    }
+
+    out << "\n]}\n";
+    return (bool)out;
+}
+
+int main(int argc, char *argv[])
+{
+    string chrome_path;
+    double bin_ms = 100;
+    vector<string> paths;
+
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg.compare(0, 9, "--chrome=") == 0)
+            chrome_path = arg.substr(9);
+        else if (arg.compare(0, 9, "--bin-ms=") == 0)
+            bin_ms = atof(arg.c_str() + 9);
+        else
+            paths.push_back(arg);
+    }
+
+    if (paths.empty() || bin_ms <= 0)
+    {
+        cout << "Usage: " << argv[0] << " [--chrome=<out.json>] [--bin-ms=<n>] <dump.bin>..." << endl;
+        cout << "  --chrome: Chrome-Trace-Event-JSON schreiben (chrome://tracing, ui.perfetto.dev)" << endl;
+        cout << "  --bin-ms: Zeitfenster fuer den Durchsatz-Zaehler (default: 100)" << endl;
+        return 1;
+    }
+
+    vector<DumpFile> dumps(paths.size());
+    vector<DecodedEvent> events;
+    vector<uint64_t> ticks;
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        if (!read_dump(paths[i], (int)i, dumps[i], events, ticks))
+            return 1;
+    }
+
+    // Alle Dumps auf den frühesten TSC-Wert beziehen
+    uint64_t first_tsc = ticks.empty() ? 0 : *min_element(ticks.begin(), ticks.end());
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        events[i].time_us = (events[i].event.tsc - first_tsc) / dumps[events[i].dump].ticks_per_ns / 1e3;
+    }
+    stable_sort(events.begin(), events.end(), [](const DecodedEvent &a, const DecodedEvent &b)
+                { return a.event.tsc < b.event.tsc; });
+
+    if (chrome_path.empty())
+    {
+        print_text(dumps, events);
+        return 0;
+    }
+
+    if (!write_chrome(chrome_path, dumps, events, bin_ms))
+        return 1;
+    cout << events.size() << " Ereignisse nach " << chrome_path << " geschrieben" << endl;
+    return 0;
+}
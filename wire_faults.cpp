@@ -0,0 +1,217 @@
+#include "wire_faults.h"
+#include "protocol.h"
+#include <cstdlib>
+#include <ctime>
+#include <sstream>
+
+using namespace std;
+
+WireFaultModel::WireFaultModel()
+    : rng(time(NULL)), visible_state(0), edge_pending(0), toggle_mask(0), toggle_left(0), events(0)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        edge_delay_left[i] = 0;
+    }
+}
+
+void WireFaultModel::add(const WireFault &fault)
+{
+    faults.push_back(fault);
+}
+
+void WireFaultModel::clear()
+{
+    faults.clear();
+    toggle_mask = 0;
+    toggle_left = 0;
+    edge_pending = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        edge_delay_left[i] = 0;
+    }
+}
+
+bool WireFaultModel::active() const
+{
+    return !faults.empty();
+}
+
+void WireFaultModel::set_seed(uint64_t seed)
+{
+    rng.seed(seed);
+}
+
+uint64_t WireFaultModel::event_count() const
+{
+    return events;
+}
+
+bool WireFaultModel::chance(double probability)
+{
+    if (probability <= 0.0)
+        return false;
+    return uniform_real_distribution<double>(0.0, 1.0)(rng) < probability;
+}
+
+uint8_t WireFaultModel::apply(uint8_t wires)
+{
+    if (faults.empty())
+    {
+        return wires;
+    }
+
+    uint8_t result = wires;
+
+    for (size_t f = 0; f < faults.size(); f++)
+    {
+        const WireFault &fault = faults[f];
+
+        switch (fault.type)
+        {
+        case FAULT_STUCK_AT_0:
+            result &= ~fault.wires;
+            break;
+
+        case FAULT_STUCK_AT_1:
+            result |= fault.wires;
+            break;
+
+        case FAULT_DELAYED_EDGE:
+            for (int bit = 0; bit < 4; bit++)
+            {
+                uint8_t mask = 1 << bit;
+                if (!(fault.wires & mask))
+                    continue;
+
+                if ((result & mask) == (visible_state & mask))
+                {
+                    edge_pending &= ~mask;
+                    edge_delay_left[bit] = 0;
+                    continue;
+                }
+
+                // Neue Flanke: genau duration Lesezugriffe lang den alten
+                // Pegel zeigen, danach den neuen
+                if (!(edge_pending & mask))
+                {
+                    edge_pending |= mask;
+                    edge_delay_left[bit] = fault.duration;
+                    events++;
+                }
+                if (edge_delay_left[bit] > 0)
+                {
+                    result = (result & ~mask) | (visible_state & mask);
+                    edge_delay_left[bit]--;
+                }
+                else
+                {
+                    edge_pending &= ~mask;
+                }
+            }
+            visible_state = result;
+            break;
+
+        case FAULT_GLITCH:
+            if (chance(fault.probability))
+            {
+                result ^= fault.wires;
+                events++;
+            }
+            break;
+
+        case FAULT_SPURIOUS_TOGGLE:
+            if (toggle_left == 0 && chance(fault.probability))
+            {
+                toggle_mask = fault.wires;
+                toggle_left = fault.duration;
+                events++;
+            }
+            break;
+        }
+    }
+
+    if (toggle_left > 0)
+    {
+        result ^= toggle_mask;
+        toggle_left--;
+    }
+
+    return result & 0x0F;
+}
+
+static bool parse_wires(const string &text, uint8_t &wires)
+{
+    wires = 0;
+    stringstream ss(text);
+    string name;
+    while (getline(ss, name, '+'))
+    {
+        if (name == "data0")
+            wires |= DATA0;
+        else if (name == "data1")
+            wires |= DATA1;
+        else if (name == "clock")
+            wires |= CLOCK;
+        else if (name == "ack")
+            wires |= ACK;
+        else if (name == "all")
+            wires |= DATA0 | DATA1 | CLOCK | ACK;
+        else
+            return false;
+    }
+    return wires != 0;
+}
+
+bool parse_wire_fault(const string &spec, WireFault &fault)
+{
+    vector<string> parts;
+    stringstream ss(spec);
+    string part;
+    while (getline(ss, part, ':'))
+    {
+        parts.push_back(part);
+    }
+
+    if (parts.size() < 2 || !parse_wires(parts[1], fault.wires))
+    {
+        return false;
+    }
+
+    fault.probability = 0.0;
+    fault.duration = 1;
+
+    const string &type = parts[0];
+    if (type == "stuck0" || type == "stuck1")
+    {
+        fault.type = (type == "stuck0") ? FAULT_STUCK_AT_0 : FAULT_STUCK_AT_1;
+        return parts.size() == 2;
+    }
+    if (type == "glitch")
+    {
+        fault.type = FAULT_GLITCH;
+        if (parts.size() != 3)
+            return false;
+        fault.probability = atof(parts[2].c_str());
+        return fault.probability > 0.0 && fault.probability <= 1.0;
+    }
+    if (type == "delay")
+    {
+        fault.type = FAULT_DELAYED_EDGE;
+        if (parts.size() != 3)
+            return false;
+        fault.duration = atoi(parts[2].c_str());
+        return fault.duration > 0;
+    }
+    if (type == "toggle")
+    {
+        fault.type = FAULT_SPURIOUS_TOGGLE;
+        if (parts.size() < 3 || parts.size() > 4)
+            return false;
+        fault.probability = atof(parts[2].c_str());
+        if (parts.size() == 4)
+            fault.duration = atoi(parts[3].c_str());
+        return fault.probability > 0.0 && fault.probability <= 1.0 && fault.duration > 0;
+    }
+    return false;
+}
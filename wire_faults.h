@@ -0,0 +1,64 @@
+#ifndef WIRE_FAULTS_H
+#define WIRE_FAULTS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <random>
+
+// Fehlerarten auf einzelnen Leitungen des Patchkabels
+enum WireFaultType
+{
+    FAULT_STUCK_AT_0,      // Leitung dauerhaft 0
+    FAULT_STUCK_AT_1,      // Leitung dauerhaft 1
+    FAULT_GLITCH,          // Leitung für genau einen Lesezugriff invertiert
+    FAULT_DELAYED_EDGE,    // Flanken werden erst nach N Lesezugriffen sichtbar
+    FAULT_SPURIOUS_TOGGLE  // Leitung springt für N Lesezugriffe um (z.B. CLOCK-Preller)
+};
+
+struct WireFault
+{
+    WireFaultType type;
+    uint8_t wires;      // Bitmaske aus DATA0/DATA1/CLOCK/ACK
+    double probability; // Glitch/Toggle: Wahrscheinlichkeit pro Lesezugriff
+    int duration;       // Delayed Edge/Toggle: Dauer in Lesezugriffen
+};
+
+// Fehlerschicht für die 4 Leitungen einer Richtung.
+// Wird beim Lesen auf den Leitungszustand angewendet, trifft also
+// Daten-, Checksum- und Kontrollbytes sowie CLOCK/ACK gleichermaßen.
+class WireFaultModel
+{
+private:
+    std::vector<WireFault> faults;
+    std::mt19937_64 rng;
+
+    uint8_t visible_state;  // Zuletzt sichtbarer Pegel (Delayed Edge)
+    uint8_t edge_pending;   // Leitungen mit noch nicht sichtbarer Flanke
+    int edge_delay_left[4]; // Pro Leitung: noch verdeckte Lesezugriffe
+    uint8_t toggle_mask;    // Aktuell umgesprungene Leitungen
+    int toggle_left;
+
+    uint64_t events;
+
+    bool chance(double probability);
+
+public:
+    WireFaultModel();
+
+    void add(const WireFault &fault);
+    void clear();
+    bool active() const;
+    void set_seed(uint64_t seed);
+
+    uint8_t apply(uint8_t wires);
+    uint64_t event_count() const;
+};
+
+// Format: typ:leitungen[:wahrscheinlichkeit][:dauer]
+//   stuck0:data0          stuck1:clock+ack
+//   glitch:data0+data1:0.001
+//   delay:ack:3           toggle:clock:0.0005:2
+bool parse_wire_fault(const std::string &spec, WireFault &fault);
+
+#endif // WIRE_FAULTS_H